@@ -0,0 +1,1128 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef DECODE_PIPELINE_H
+#define DECODE_PIPELINE_H
+
+#include "tpx3_decoder.h"
+#include "timestamp_extension.h"
+#include "hit_processor.h"
+#include "tpx3_packets.h"
+#include "packet_reorder_buffer.h"
+#include "hit_block.h"
+#include "hit_sort.h"
+#include "energy_calibration.h"
+#include "time_walk.h"
+#include "pixel_mask.h"
+#include "hit_filter.h"
+#include "time_ordered_merge.h"
+#include "latency_histogram.h"
+#include "numa_memory.h"
+#include "thread_affinity.h"
+#include "work_stealing.h"
+#include "lockfree_queue.h"
+#include "dispatch_policy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Raw stream processing shared by the parser and the benchmarks: chunk
+// framing (process_raw_data), packet decoding (process_packet), the
+// per-chip decode workers (DecodeDispatcher) and the block stages
+// (ChunkHitCollector).
+
+enum class ChunkSortMethod { Radix, Comparison };
+
+// Block stages run on every finished chunk run (shared, read-only while decoding)
+struct BlockStageConfig {
+    const EnergyCalibration* calibration = nullptr;
+    const TimeWalkCorrection* time_walk = nullptr;
+    const HitFilter* filter = nullptr;
+    Tdc1History* tdc1_history = nullptr;  // Set when the filter has a ToF window
+    TimeOrderedMerger* merger = nullptr;
+    ChunkSortMethod sort_method = ChunkSortMethod::Radix;
+    size_t energy_bins = 1000;
+    double energy_bin_kev = 1.0;
+    size_t max_deferred_hits = 1000000;  // Per collector, waiting for the TDC1 history
+
+    bool enabled() const {
+        return calibration != nullptr || time_walk != nullptr || filter != nullptr || merger != nullptr;
+    }
+};
+
+// Collects decoded hits per chip into chunk runs and applies the block stages
+// when a chunk completes: time-walk correction, filtering, energy calibration,
+// then a ToA sort and hand-off to the time-ordered merge stage. One instance
+// per decoding thread.
+//
+// With a ToF filter, runs wait (in arrival order, so per-chip order is kept)
+// until the TDC1 history is complete up to their newest hit, bounded by
+// max_deferred_hits.
+class ChunkHitCollector {
+public:
+    explicit ChunkHitCollector(const BlockStageConfig& stages)
+        : stages_(stages), tdc1_(stages.tdc1_history), open_runs_(256), deferred_hits_(0) {
+        energy_spectrum_.configure(stages_.energy_bins, stages_.energy_bin_kev);
+    }
+    
+    void add(const PixelHit& hit) {
+        open_runs_[hit.chip_index].push_back(hit);
+    }
+    
+    void finishChunk(uint8_t chip_index, const ChunkMetadata& meta) {
+        HitBlock& run = open_runs_[chip_index];
+        if (run.empty()) {
+            return;
+        }
+        if (stages_.time_walk) {
+            stages_.time_walk->apply(run);
+        }
+        // Newest hit before filtering: chip progress must not depend on the filter
+        uint64_t newest = *std::max_element(run.toa.begin(), run.toa.end());
+        if (!tdc1_) {
+            processRun(chip_index, meta, run, newest);
+            run.clear();
+            return;
+        }
+        tdc1_->advanceHorizon(chip_index, newest);
+        deferred_hits_ += run.size();
+        deferred_.push_back(PendingRun{chip_index, meta, std::move(run), newest});
+        run.clear();
+        drainDeferred(false);
+    }
+    
+    // Close runs of chunks that never completed (end of stream)
+    void finishAll() {
+        for (size_t chip = 0; chip < open_runs_.size(); ++chip) {
+            finishChunk(static_cast<uint8_t>(chip), ChunkMetadata{});
+        }
+        drainDeferred(true);
+    }
+    
+    const EnergySpectrum& energySpectrum() const { return energy_spectrum_; }
+    const HitFilter::Statistics& filterStatistics() const { return filter_stats_; }
+    
+private:
+    struct PendingRun {
+        uint8_t chip_index;
+        ChunkMetadata meta;
+        HitBlock hits;
+        uint64_t newest;
+    };
+    
+    void drainDeferred(bool force) {
+        while (!deferred_.empty()) {
+            PendingRun& pending = deferred_.front();
+            bool ready = pending.newest <= tdc1_->horizon();
+            if (!ready && !force && deferred_hits_ <= stages_.max_deferred_hits) {
+                break;
+            }
+            deferred_hits_ -= pending.hits.size();
+            processRun(pending.chip_index, pending.meta, pending.hits, pending.newest);
+            deferred_.pop_front();
+        }
+    }
+    
+    void processRun(uint8_t chip_index, const ChunkMetadata& meta, HitBlock& run, uint64_t newest) {
+        if (stages_.filter) {
+            stages_.filter->apply(run, filter_scratch_, filter_stats_);
+        }
+        if (stages_.calibration && !run.empty()) {
+            stages_.calibration->apply(run, calibration_scratch_);
+            energy_spectrum_.add(run);
+        }
+        if (stages_.merger) {
+            // Readout is column-ordered, so chunks are not time-ordered
+            if (stages_.sort_method == ChunkSortMethod::Radix) {
+                radix_sort_hits_by_toa(run, sort_scratch_);
+            } else {
+                sort_hits_by_toa(run);
+            }
+            uint64_t progress = newest;
+            if (meta.has_extra_packets) {
+                // Chunk max timestamp, placed in the same time base as the extended ToA
+                progress = std::max(progress, TimestampExtender::placeNear(
+                    meta.max_timestamp_ns, progress, TimestampExtender::PIXEL_TOA_BITS));
+            }
+            stages_.merger->pushRun(chip_index, std::move(run), progress);
+        }
+    }
+    
+    BlockStageConfig stages_;
+    Tdc1History* tdc1_;
+    HitSortScratch sort_scratch_;
+    HitFilter::Scratch filter_scratch_;
+    HitFilter::Statistics filter_stats_;
+    EnergyCalibration::Scratch calibration_scratch_;
+    EnergySpectrum energy_spectrum_;
+    std::vector<HitBlock> open_runs_;  // Indexed by 8-bit chip index
+    std::deque<PendingRun> deferred_;
+    size_t deferred_hits_;
+};
+
+// Optional decode stages used by process_packet
+struct DecodeContext {
+    TimestampExtender* extender = nullptr;
+    PixelMask* mask = nullptr;             // Drops masked pixel hits before decoding
+    Tdc1History* tdc1_history = nullptr;   // TDC1 references for the ToF filter
+    ChunkHitCollector* collector = nullptr;
+};
+
+void process_packet(uint64_t word, uint8_t chip_index, HitProcessor& processor, const ChunkMetadata& chunk_meta, bool enable_accounting = true,
+                    const DecodeContext& ctx = DecodeContext{});
+
+struct StreamState {
+    static constexpr size_t DEFAULT_BATCH_SIZE = 128;
+
+    bool in_chunk = false;
+    size_t chunk_words_remaining = 0;
+    uint8_t chip_index = 0;
+    uint64_t current_chunk_id = 0;
+    uint64_t local_chunk_count = 0;  // Local counter to avoid mutex locks
+    uint64_t pending_chunk_updates = 0;  // Batch chunk count updates
+    ChunkMetadata chunk_meta{};
+    std::vector<ExtraTimestamp> extra_timestamps;
+    bool saw_first_chunk_header = false;
+    bool mid_stream_flagged = false;
+    std::vector<uint64_t> batch_buffer;  // Batch buffer for dispatcher submissions
+    size_t batch_size = DEFAULT_BATCH_SIZE;  // Words per dispatcher submission
+    TimestampExtender extender;  // Per-chip ToA/TDC extension (used by whichever thread decodes)
+    DecodeContext decode;        // Stages for inline decoding (no dispatcher)
+    // With a dispatcher: the mode in effect, and the policy that may change it at
+    // chunk boundaries (nullptr = always parallel)
+    DecodeMode decode_mode = DecodeMode::Parallel;
+    DispatchPolicy* dispatch_policy = nullptr;
+
+    StreamState() {
+        decode.extender = &extender;
+        extra_timestamps.reserve(3);
+        batch_buffer.reserve(DEFAULT_BATCH_SIZE);  // Pre-allocate batch buffer
+    }
+};
+
+// Consecutive words of one chip's chunk as queued for the decoder workers;
+// the words themselves follow in the chip's word ring
+struct DecodeSegment {
+    ChunkMetadata chunk_meta{};
+    uint64_t submit_ns = 0;  // Submission time when task latency is recorded (steady clock)
+    uint32_t words = 0;
+    bool chunk_end = false;  // Marker: all words of the chip's current chunk were submitted
+};
+
+// Thread-safe queue for raw data buffers between network and processing threads
+class RawDataQueue {
+public:
+    struct Buffer {
+        std::vector<uint8_t> data;  // Heap copy (no pool, or larger than a pool slot)
+        uint8_t* slot = nullptr;    // Pool slot; handed back to the pool by the next pop()
+        size_t size = 0;
+        std::chrono::steady_clock::time_point enqueued;
+        
+        Buffer() = default;
+        Buffer(const uint8_t* src, size_t len)
+            : data(src, src + len), size(len), enqueued(std::chrono::steady_clock::now()) {}
+        Buffer(uint8_t* pool_slot, const uint8_t* src, size_t len)
+            : slot(pool_slot), size(len), enqueued(std::chrono::steady_clock::now()) {
+            std::memcpy(slot, src, len);
+        }
+        
+        const uint8_t* bytes() const { return slot ? slot : data.data(); }
+    };
+    
+    RawDataQueue(size_t max_buffers = 100) 
+        : max_buffers_(max_buffers), 
+          stop_(false),
+          dropped_buffers_(0) {}
+    
+    // Copy pushed data into preallocated slots placed on the consumer's NUMA
+    // node (node < 0: first touch) instead of one heap allocation per push.
+    // One slot per queued buffer plus the one the consumer holds. Call before
+    // the first push; error is also set when only the node binding failed.
+    bool enablePool(size_t slot_bytes, int node, HugePages pages, std::string& error) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pool_.allocate(slot_bytes, max_buffers_ + 1, node, pages, error);
+    }
+    
+    // Setup only (before the first push)
+    BufferPool& pool() { return pool_; }
+    const BufferPool& pool() const { return pool_; }
+    
+    // Push a buffer (non-blocking, drops if full)
+    // Returns true if successfully enqueued, false if dropped
+    bool push(const uint8_t* data, size_t size) {
+        if (stop_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        
+        std::unique_lock<std::mutex> lock(mutex_);
+        
+        // Drop oldest buffer if queue is full (flow control)
+        if (queue_.size() >= max_buffers_) {
+            releaseSlot(queue_.front());
+            queue_.pop();
+            dropped_buffers_.fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        uint8_t* slot = size <= pool_.slotBytes() ? pool_.acquire() : nullptr;
+        if (slot) {
+            queue_.emplace(slot, data, size);
+        } else {
+            queue_.emplace(data, size);
+        }
+        lock.unlock();
+        cond_.notify_one();
+        return true;
+    }
+    
+    // Pop a buffer (blocking with timeout)
+    // Returns true if buffer was retrieved, false if timeout or stopped
+    bool pop(Buffer& buffer, std::chrono::milliseconds timeout = std::chrono::milliseconds(100)) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // The consumer is done with the previously popped buffer
+        releaseSlot(buffer);
+        
+        bool notified = cond_.wait_for(lock, timeout, [this]() {
+            return !queue_.empty() || stop_.load(std::memory_order_acquire);
+        });
+        
+        if (!notified || queue_.empty()) {
+            return false;
+        }
+        
+        buffer = std::move(queue_.front());
+        queue_.front().slot = nullptr;
+        queue_.pop();
+        return true;
+    }
+    
+    // Signal shutdown
+    void stop() {
+        stop_.store(true, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(mutex_);
+        cond_.notify_all();
+    }
+    
+    // Check if stopped
+    bool isStopped() const {
+        return stop_.load(std::memory_order_acquire);
+    }
+    
+    // Get number of dropped buffers
+    uint64_t getDroppedBuffers() const {
+        return dropped_buffers_.load(std::memory_order_acquire);
+    }
+    
+    // Get current queue size (approximate)
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+    
+    size_t capacity() const { return max_buffers_; }
+    
+private:
+    // Caller holds mutex_
+    void releaseSlot(Buffer& buffer) {
+        if (buffer.slot) {
+            pool_.release(buffer.slot);
+            buffer.slot = nullptr;
+        }
+    }
+    
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::queue<Buffer> queue_;
+    size_t max_buffers_;
+    std::atomic<bool> stop_;
+    std::atomic<uint64_t> dropped_buffers_;
+    BufferPool pool_;
+};
+
+// Decoder worker pool with work stealing. Submitted words are appended to the
+// strand of their chip (lock-free SPSC rings of words and segments, run by
+// at most one worker at a time), so per-chip order is kept for every stage
+// that depends on it: timestamp extension, hot-pixel detection, the TDC1
+// history and the block stages. A strand's pending-segment count decides who
+// schedules it: the submit that raises it from zero puts the strand on the
+// lock-free injection queue; the worker that runs it drains the segments it
+// saw and, if more arrived meanwhile, pushes it on its own Chase-Lev deque.
+// Idle workers steal strands from the other deques, so any worker can decode
+// any chip; they spin briefly, then sleep on a futex.
+//
+// Submission is single-producer (the processing thread). The rings are
+// bounded: when a chip's ring is full the submitter yields until the worker
+// running that strand makes room.
+class DecodeDispatcher {
+public:
+    struct PartialStats {
+        uint64_t hits = 0;
+        uint64_t tdc1 = 0;
+        uint64_t tdc2 = 0;
+        uint64_t earliest_hit_tick = std::numeric_limits<uint64_t>::max();
+        uint64_t latest_hit_tick = 0;
+        uint64_t earliest_tdc1_tick = std::numeric_limits<uint64_t>::max();
+        uint64_t latest_tdc1_tick = 0;
+        uint64_t chip_out_of_range = 0;
+        // Contiguous per-chip counters, sized to HitProcessor::chipCount()
+        std::vector<uint64_t> chip_hits;
+        std::vector<uint64_t> chip_tdc1;
+        std::vector<uint64_t> chip_tdc2;
+        std::vector<uint64_t> chip_tdc1_min;
+        std::vector<uint64_t> chip_tdc1_max;
+        std::vector<PixelHit> recent_hits;
+
+        bool empty() const {
+            return hits == 0 && tdc1 == 0 && tdc2 == 0 && chip_out_of_range == 0 && recent_hits.empty();
+        }
+
+        void mergeInto(HitProcessor& processor) {
+            if (empty()) {
+                return;
+            }
+            std::lock_guard<std::recursive_mutex> lock(processor.mutex_);
+            processor.stats_.total_hits += hits;
+            processor.stats_.total_tdc1_events += tdc1;
+            processor.stats_.total_tdc2_events += tdc2;
+            processor.stats_.total_tdc_events += (tdc1 + tdc2);
+            processor.stats_.chip_index_out_of_range += chip_out_of_range;
+            size_t chips = std::min(chip_hits.size(), processor.chip_hit_totals_.size());
+            for (size_t chip = 0; chip < chips; ++chip) {
+                processor.chip_hit_totals_[chip] += chip_hits[chip];
+                processor.stats_.chip_hit_rate_valid[chip] =
+                    processor.stats_.chip_hit_rate_valid[chip] || chip_hits[chip] > 0;
+                processor.stats_.chip_tdc1_counts[chip] += chip_tdc1[chip];
+                if (chip_tdc1[chip] > 0) {
+                    processor.stats_.chip_tdc1_present[chip] = true;
+                    processor.chip_tdc1_min_ticks_[chip] =
+                        std::min(processor.chip_tdc1_min_ticks_[chip], chip_tdc1_min[chip]);
+                    processor.chip_tdc1_max_ticks_[chip] =
+                        std::max(processor.chip_tdc1_max_ticks_[chip], chip_tdc1_max[chip]);
+                }
+            }
+            if (hits > 0) {
+                if (!processor.stats_.hit_time_initialized ||
+                    earliest_hit_tick < processor.stats_.earliest_hit_time_ticks) {
+                    processor.stats_.earliest_hit_time_ticks = earliest_hit_tick;
+                    processor.stats_.hit_time_initialized = true;
+                }
+                if (latest_hit_tick > processor.stats_.latest_hit_time_ticks) {
+                    processor.stats_.latest_hit_time_ticks = latest_hit_tick;
+                }
+            }
+            if (tdc1 > 0) {
+                if (!processor.stats_.tdc1_time_initialized ||
+                    earliest_tdc1_tick < processor.stats_.earliest_tdc1_time_ticks) {
+                    processor.stats_.earliest_tdc1_time_ticks = earliest_tdc1_tick;
+                    processor.stats_.tdc1_time_initialized = true;
+                }
+                if (latest_tdc1_tick > processor.stats_.latest_tdc1_time_ticks) {
+                    processor.stats_.latest_tdc1_time_ticks = latest_tdc1_tick;
+                }
+            }
+            if (processor.recent_hit_capacity_ > 0) {
+                for (const auto& hit : recent_hits) {
+                    if (processor.recent_hits_buffer_.size() != processor.recent_hit_capacity_) {
+                        processor.recent_hits_buffer_.assign(
+                            processor.recent_hit_capacity_, PixelHit{});
+                    }
+                    processor.recent_hits_buffer_[processor.recent_hits_head_] = hit;
+                    processor.recent_hits_head_ =
+                        (processor.recent_hits_head_ + 1) % processor.recent_hit_capacity_;
+                    if (processor.recent_hits_size_ < processor.recent_hit_capacity_) {
+                        processor.recent_hits_size_++;
+                    }
+                }
+            }
+        }
+
+        void reset(size_t recent_capacity, size_t chip_count) {
+            hits = tdc1 = tdc2 = 0;
+            earliest_hit_tick = std::numeric_limits<uint64_t>::max();
+            latest_hit_tick = 0;
+            earliest_tdc1_tick = std::numeric_limits<uint64_t>::max();
+            latest_tdc1_tick = 0;
+            chip_out_of_range = 0;
+            chip_hits.assign(chip_count, 0);
+            chip_tdc1.assign(chip_count, 0);
+            chip_tdc2.assign(chip_count, 0);
+            chip_tdc1_min.assign(chip_count, std::numeric_limits<uint64_t>::max());
+            chip_tdc1_max.assign(chip_count, 0);
+            recent_hits.clear();
+            if (recent_capacity > 0) {
+                recent_hits.reserve(recent_capacity);
+            }
+        }
+    };
+
+    // worker_cpus: worker i pins itself to worker_cpus[i % size] (empty = unpinned).
+    // Each worker allocates its own deque and statistics after pinning, and the
+    // strand rings of its home chips (chip % workers, below the chip count), so
+    // that memory is first touched on the worker's NUMA node; the constructor
+    // returns once all workers are ready.
+    DecodeDispatcher(size_t num_workers, HitProcessor& processor, size_t recent_cap,
+                     const DecodeContext& decode = DecodeContext{}, const BlockStageConfig& stages = BlockStageConfig{},
+                     const std::vector<int>& worker_cpus = {})
+        : processor_(processor),
+          extender_(decode.extender),
+          stages_(stages),
+          stop_(false),
+          pending_tasks_(0),
+          recent_capacity_(recent_cap),
+          chip_count_(processor.chipCount()) {
+        size_t workers = std::max<size_t>(1, num_workers);
+        strands_.reserve(MAX_CHIPS);
+        for (size_t chip = 0; chip < MAX_CHIPS; ++chip) {
+            strands_.emplace_back(std::make_unique<ChipStrand>());
+            strands_.back()->chip_index = static_cast<uint8_t>(chip);
+        }
+        worker_data_.reserve(workers);
+        for (size_t i = 0; i < workers; ++i) {
+            worker_data_.emplace_back(std::make_unique<WorkerData>());
+            auto& data = *worker_data_.back();
+            data.ctx = decode;
+            data.cpu = worker_cpus.empty() ? -1 : worker_cpus[i % worker_cpus.size()];
+        }
+        workers_.reserve(workers);
+        for (size_t i = 0; i < workers; ++i) {
+            workers_.emplace_back([this, i]() {
+                initializeWorker(*worker_data_[i], i);
+                workerLoop(i);
+            });
+        }
+        std::unique_lock<std::mutex> lock(ready_mutex_);
+        ready_cv_.wait(lock, [this]() { return ready_workers_ == worker_data_.size(); });
+    }
+
+    ~DecodeDispatcher() {
+        stop();
+        if (strands_locked_) {
+            for (const auto& strand : strands_) {
+                // munlock of a never-locked range is harmless
+                unlock_memory(strand->words.data(), strand->words.bytes());
+                unlock_memory(strand->segments.data(), strand->segments.bytes());
+            }
+        }
+    }
+
+    // Batch submit multiple words: one ring push and one scheduling check per batch
+    void submitBatch(const std::vector<uint64_t>& words, uint8_t chip_index, const ChunkMetadata& meta) {
+        for (size_t offset = 0; offset < words.size(); offset += MAX_SEGMENT_WORDS) {
+            enqueue(chip_index, words.data() + offset, std::min(MAX_SEGMENT_WORDS, words.size() - offset),
+                    meta, false);
+        }
+    }
+
+    // Close the chip's chunk run for the block stages (ordered after its words)
+    void submitChunkEnd(uint8_t chip_index, const ChunkMetadata& meta) {
+        if (!stages_.enabled()) {
+            return;
+        }
+        enqueue(chip_index, nullptr, 0, meta, true);
+    }
+
+    // Hand partially collected chunk runs to the block stages.
+    // Only call while idle (after waitUntilIdle) or after stop().
+    void finishChunks() {
+        for (auto& strand : strands_) {
+            if (strand->collector) {
+                strand->collector->finishAll();
+            }
+        }
+    }
+
+    size_t workerCount() const { return worker_data_.size(); }
+
+    // mlock the strand rings allocated at startup (--preallocate; they are
+    // already prefaulted by their home workers). Returns the bytes locked.
+    size_t lockStrandRings(std::string& error) {
+        size_t locked = 0;
+        for (const auto& strand : strands_) {
+            if (!strand->words.allocated()) {
+                continue;
+            }
+            strands_locked_ = true;  // Unlocked in the destructor, also after a partial failure
+            if (!lock_memory(strand->words.data(), strand->words.bytes(), error) ||
+                !lock_memory(strand->segments.data(), strand->segments.bytes(), error)) {
+                break;
+            }
+            locked += strand->words.bytes() + strand->segments.bytes();
+        }
+        return locked;
+    }
+
+    // Placement of a worker: its CPU (-1 = unpinned), the pinning error if any,
+    // and the NUMA node it started on
+    int workerCpu(size_t index) const { return worker_data_[index]->cpu; }
+    const std::string& workerPlacementError(size_t index) const { return worker_data_[index]->placement_error; }
+    int workerNumaNode(size_t index) const { return worker_data_[index]->numa_node; }
+
+    // Chip strands waiting on one worker's deque (telemetry, approximate)
+    size_t workerQueueLength(size_t index) const { return worker_data_[index]->deque.size(); }
+
+    // Times the submitter waited for room in a chip's ring
+    uint64_t submitStalls() const { return submit_stalls_.load(std::memory_order_relaxed); }
+
+    // Strands taken from another worker's deque, over all workers
+    uint64_t stolenRuns() const {
+        uint64_t total = 0;
+        for (const auto& data : worker_data_) {
+            total += data->steals.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // Words submitted but not yet decoded, over all workers
+    size_t pendingTasks() const { return pending_tasks_.load(std::memory_order_relaxed); }
+
+    // Ask every worker to publish its partial statistics after the batch it is
+    // decoding (idle workers are woken). Returns the epoch to pass to
+    // statisticsPublished() / waitForStatistics(), which merge the published
+    // buffers into the HitProcessor; nothing waits for the queues to drain.
+    uint64_t requestStatistics() {
+        uint64_t epoch = stats_epoch_.fetch_add(1, std::memory_order_acq_rel) + 1;
+        wakeWorkers(static_cast<int>(worker_data_.size()));
+        return epoch;
+    }
+
+    // True once every worker has published at or after the given epoch; the
+    // published statistics are then in the HitProcessor
+    bool statisticsPublished(uint64_t epoch) {
+        bool published = allPublished(epoch);
+        collectPublished();
+        return published;
+    }
+
+    // For reporting threads outside the data path: wait at most `timeout`
+    bool waitForStatistics(uint64_t epoch, std::chrono::milliseconds timeout) {
+        bool published;
+        {
+            std::unique_lock<std::mutex> lock(published_mutex_);
+            published = published_cv_.wait_for(lock, timeout, [this, epoch]() { return allPublished(epoch); });
+        }
+        collectPublished();
+        return published;
+    }
+
+    // Record batch submission to decode start per worker (call before submitting)
+    void enableTaskLatency() { record_latency_ = true; }
+    bool taskLatencyEnabled() const { return record_latency_; }
+
+    // Merged task latency of all workers; safe while decoding
+    LatencyHistogram::Snapshot collectTaskLatency() const {
+        LatencyHistogram::Snapshot total;
+        for (const auto& data : worker_data_) {
+            total.merge(data->task_latency.snapshot());
+        }
+        return total;
+    }
+
+    // Combine the workers' energy spectra. Only call while idle or after stop().
+    void collectEnergySpectrum(EnergySpectrum& total) const {
+        for (const auto& strand : strands_) {
+            if (strand->collector) {
+                total.merge(strand->collector->energySpectrum());
+            }
+        }
+    }
+
+    // Combine the workers' filter counters. Only call while idle or after stop().
+    void collectFilterStatistics(HitFilter::Statistics& total) const {
+        for (const auto& strand : strands_) {
+            if (strand->collector) {
+                total.merge(strand->collector->filterStatistics());
+            }
+        }
+    }
+
+    // Wait until every submitted word is decoded, without collecting statistics
+    // (switching to inline decode: per-chip state then belongs to the caller)
+    void waitUntilDrained() {
+        std::unique_lock<std::mutex> lock(pending_mutex_);
+        idle_cv_.wait(lock, [this]() {
+            return pending_tasks_.load(std::memory_order_acquire) == 0;
+        });
+    }
+
+    // Block-stage collector of a chip's strand (nullptr without block stages),
+    // for inline decode. Only use while drained: a chip keeps one collector
+    // whichever thread decodes it, so its runs stay in order across mode switches.
+    ChunkHitCollector* chipCollector(uint8_t chip_index) {
+        ChipStrand& strand = *strands_[chip_index];
+        if (!strand.collector && stages_.enabled()) {
+            strand.collector = std::make_unique<ChunkHitCollector>(stages_);
+        }
+        return strand.collector.get();
+    }
+
+    void waitUntilIdle() {
+        std::unique_lock<std::mutex> lock(pending_mutex_);
+        idle_cv_.wait(lock, [this]() {
+            return pending_tasks_.load(std::memory_order_acquire) == 0;
+        });
+        flushAll();
+    }
+
+    void stop() {
+        bool expected = false;
+        if (!stop_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            return;
+        }
+        wakeWorkers(static_cast<int>(worker_data_.size()));
+        for (auto& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        workers_.clear();
+        flushAll();
+    }
+
+    // Bring every worker's statistics into the HitProcessor. Only call while
+    // idle or after stop(): running workers publish through an epoch, stopped
+    // ones are read directly.
+    void flushAll() {
+        if (!workers_.empty()) {
+            uint64_t epoch = requestStatistics();
+            std::unique_lock<std::mutex> lock(published_mutex_);
+            published_cv_.wait(lock, [this, epoch]() { return allPublished(epoch); });
+        } else {
+            for (auto& data : worker_data_) {
+                data->stats.mergeInto(processor_);
+                data->stats.reset(recent_capacity_, chip_count_);
+            }
+        }
+        collectPublished();
+    }
+
+private:
+    static constexpr size_t MAX_CHIPS = 256;  // 8-bit chip index
+    static constexpr size_t DEQUE_CAPACITY = MAX_CHIPS;  // A strand is queued at most once
+    static constexpr size_t STRAND_WORDS = 1 << 16;      // Per-chip word ring (512 KB)
+    static constexpr size_t STRAND_SEGMENTS = 1 << 12;
+    static constexpr size_t MAX_SEGMENT_WORDS = STRAND_WORDS / 4;
+    static constexpr size_t PUBLISH_CHECK_WORDS = 4096;  // Statistics requests checked within long runs
+    static constexpr int SPIN_ROUNDS = 2000;             // Polls before sleeping (multi-core only)
+    static constexpr long SLEEP_TIMEOUT_MS = 100;
+
+    // Per-chip FIFO. pending_segments > 0 while the strand is queued or running.
+    // The rings of chips below the chip count are allocated and prefaulted by
+    // their home worker at startup; an out-of-range chip's on its first word.
+    struct alignas(64) ChipStrand {
+        SpscRing<uint64_t> words;
+        SpscRing<DecodeSegment> segments;
+        std::atomic<size_t> pending_segments{0};
+        uint8_t chip_index = 0;
+        std::unique_ptr<ChunkHitCollector> collector;  // Used only by the worker running the strand
+    };
+
+    // Publication buffer states (WorkerData::outbox_state)
+    static constexpr int OUTBOX_EMPTY = 0;
+    static constexpr int OUTBOX_FULL = 1;     // Swapped in by the worker, not yet merged
+    static constexpr int OUTBOX_MERGING = 2;  // Claimed by a reporting thread
+
+    struct WorkerData {
+        ChaseLevDeque<ChipStrand> deque;
+        PartialStats stats;   // Written by the worker only, without locking
+        PartialStats outbox;  // Published statistics, owned by outbox_state
+        std::atomic<int> outbox_state{OUTBOX_EMPTY};
+        DecodeContext ctx;
+        std::atomic<uint64_t> steals{0};
+        LatencyHistogram task_latency;  // Written by the worker only
+        std::atomic<uint64_t> published_epoch{0};  // Last statistics epoch merged by the worker
+        int cpu = -1;
+        int numa_node = -1;
+        std::string placement_error;
+    };
+
+    static uint64_t steadyNowNs() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    HitProcessor& processor_;
+    TimestampExtender* extender_;  // Per-chip state; only the worker running a chip's strand touches it
+    BlockStageConfig stages_;
+    std::vector<std::thread> workers_;
+    std::vector<std::unique_ptr<WorkerData>> worker_data_;
+    std::vector<std::unique_ptr<ChipStrand>> strands_;  // Indexed by chip
+    MpmcQueue<ChipStrand*> injected_{2 * MAX_CHIPS};  // Strands that became runnable (never full)
+    std::atomic<size_t> sleepers_{0};
+    std::atomic<uint32_t> work_generation_{0};  // Futex word, bumped whenever a strand becomes runnable
+    std::atomic<uint64_t> submit_stalls_{0};
+    int spin_rounds_ = std::thread::hardware_concurrency() > 1 ? SPIN_ROUNDS : 0;
+    std::atomic<bool> stop_;
+    std::atomic<size_t> pending_tasks_;
+    std::mutex pending_mutex_;
+    std::condition_variable idle_cv_;
+    size_t recent_capacity_;
+    size_t chip_count_;
+    bool record_latency_ = false;
+    std::atomic<uint64_t> stats_epoch_{0};
+    std::mutex published_mutex_;
+    std::condition_variable published_cv_;
+    std::mutex ready_mutex_;
+    std::condition_variable ready_cv_;
+    size_t ready_workers_ = 0;
+    bool strands_locked_ = false;
+
+    // On the worker thread, before any task: pin, then allocate worker-owned
+    // memory and the rings of the worker's home chips
+    void initializeWorker(WorkerData& data, size_t index) {
+        if (data.cpu >= 0) {
+            pin_current_thread({data.cpu}, data.placement_error);
+        }
+        data.numa_node = current_numa_node();
+        data.stats.reset(recent_capacity_, chip_count_);
+        data.outbox.reset(recent_capacity_, chip_count_);
+        data.deque.reserve(DEQUE_CAPACITY);
+        for (size_t chip = index; chip < std::min(chip_count_, MAX_CHIPS); chip += worker_data_.size()) {
+            allocateStrand(*strands_[chip]);
+        }
+        std::lock_guard<std::mutex> lock(ready_mutex_);
+        ++ready_workers_;
+        ready_cv_.notify_all();
+    }
+
+    bool statisticsRequested(const WorkerData& data) const {
+        return stats_epoch_.load(std::memory_order_acquire) != data.published_epoch.load(std::memory_order_relaxed);
+    }
+
+    bool allPublished(uint64_t epoch) const {
+        for (const auto& data : worker_data_) {
+            if (data->published_epoch.load(std::memory_order_acquire) < epoch) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // At a batch boundary, if a reporter asked for statistics: swap the partial
+    // statistics into the outbox for the reporter to merge. If the previous
+    // outbox was not merged yet, the worker merges its statistics itself.
+    void publishIfRequested(WorkerData& data) {
+        uint64_t epoch = stats_epoch_.load(std::memory_order_acquire);
+        if (epoch == data.published_epoch.load(std::memory_order_relaxed)) {
+            return;
+        }
+        if (!data.stats.empty()) {
+            if (data.outbox_state.load(std::memory_order_acquire) == OUTBOX_EMPTY) {
+                std::swap(data.stats, data.outbox);  // Merged outboxes are left reset
+                data.outbox_state.store(OUTBOX_FULL, std::memory_order_release);
+            } else {
+                data.stats.mergeInto(processor_);
+                data.stats.reset(recent_capacity_, chip_count_);
+            }
+        }
+        data.published_epoch.store(epoch, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(published_mutex_);
+        }
+        published_cv_.notify_all();
+    }
+
+    // Submitter side: append to the chip's rings, scheduling the strand if it was idle
+    void enqueue(uint8_t chip_index, const uint64_t* words, size_t count, const ChunkMetadata& meta,
+                 bool chunk_end) {
+        ChipStrand& strand = *strands_[chip_index];
+        if (!strand.words.allocated()) {
+            allocateStrand(strand);  // Out-of-range chip, not allocated at startup
+        }
+        pending_tasks_.fetch_add(count + (chunk_end ? 1 : 0), std::memory_order_release);
+        DecodeSegment segment{meta, record_latency_ && count > 0 ? steadyNowNs() : 0,
+                              static_cast<uint32_t>(count), chunk_end};
+        // The strand is scheduled while its rings hold data, so room will be made
+        if (!strand.words.tryPush(words, count)) {
+            submit_stalls_.fetch_add(1, std::memory_order_relaxed);
+            while (!strand.words.tryPush(words, count)) {
+                std::this_thread::yield();
+            }
+        }
+        while (!strand.segments.tryPush(&segment, 1)) {
+            std::this_thread::yield();
+        }
+        if (strand.pending_segments.fetch_add(1, std::memory_order_acq_rel) == 0) {
+            inject(strand);
+        }
+    }
+
+    static void allocateStrand(ChipStrand& strand) {
+        strand.words.reserve(STRAND_WORDS);
+        strand.segments.reserve(STRAND_SEGMENTS);
+        strand.words.prefault();
+        strand.segments.prefault();
+    }
+
+    void inject(ChipStrand& strand) {
+        while (!injected_.tryPush(&strand)) {
+            std::this_thread::yield();  // Unreachable: each strand is queued at most once
+        }
+        wakeWorkers(1);
+    }
+
+    // Registering as a sleeper before re-checking for work (workerLoop) pairs with
+    // bumping the generation before reading the sleeper count here
+    void wakeWorkers(int count) {
+        work_generation_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+            futex_wake(work_generation_, count);
+        }
+    }
+
+    // Own deque (newest first), then the injection queue, then the other
+    // workers' deques (oldest first)
+    ChipStrand* findWork(size_t index) {
+        WorkerData& data = *worker_data_[index];
+        if (ChipStrand* strand = data.deque.pop()) {
+            return strand;
+        }
+        ChipStrand* injected = nullptr;
+        if (injected_.tryPop(injected)) {
+            return injected;
+        }
+        for (size_t offset = 1; offset < worker_data_.size(); ++offset) {
+            WorkerData& victim = *worker_data_[(index + offset) % worker_data_.size()];
+            if (ChipStrand* strand = victim.deque.steal()) {
+                data.steals.fetch_add(1, std::memory_order_relaxed);
+                return strand;
+            }
+        }
+        return nullptr;
+    }
+
+    bool workVisible() const {
+        if (!injected_.empty()) {
+            return true;
+        }
+        for (const auto& data : worker_data_) {
+            if (!data->deque.empty()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool drained() const {
+        return stop_.load(std::memory_order_acquire) && pending_tasks_.load(std::memory_order_acquire) == 0;
+    }
+
+    void workerLoop(size_t index) {
+        WorkerData& data = *worker_data_[index];
+        while (true) {
+            if (ChipStrand* strand = findWork(index)) {
+                runStrand(*strand, data);
+                publishIfRequested(data);
+                continue;
+            }
+            publishIfRequested(data);
+            if (drained()) {
+                break;
+            }
+
+            // At high rates the next batch is microseconds away: poll before sleeping
+            int spins = 0;
+            while (spins < spin_rounds_ && !workVisible() && !statisticsRequested(data) && !drained()) {
+                cpu_relax();
+                ++spins;
+            }
+            if (spins < spin_rounds_) {
+                continue;
+            }
+
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            uint32_t generation = work_generation_.load(std::memory_order_seq_cst);
+            if (!workVisible() && !statisticsRequested(data) && !drained()) {
+                futex_wait(work_generation_, generation, SLEEP_TIMEOUT_MS);
+            }
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Decode the segments queued when the run starts, releasing ring space per
+    // segment; requeue the strand if more arrived meanwhile
+    void runStrand(ChipStrand& strand, WorkerData& data) {
+        size_t segments = strand.pending_segments.load(std::memory_order_acquire);
+        if (!strand.collector && stages_.enabled()) {
+            strand.collector = std::make_unique<ChunkHitCollector>(stages_);
+        }
+        DecodeContext ctx = data.ctx;
+        ctx.collector = strand.collector.get();
+        size_t decoded = 0;
+        size_t since_publish = 0;
+        for (size_t i = 0; i < segments; ++i) {
+            const DecodeSegment segment = strand.segments.at(0);
+            if (segment.submit_ns != 0) {
+                data.task_latency.record(steadyNowNs() - segment.submit_ns);
+            }
+            for (uint32_t w = 0; w < segment.words; ++w) {
+                processWord(strand.words.at(w), strand.chip_index, segment.chunk_meta, data, ctx);
+            }
+            if (segment.chunk_end && ctx.collector) {
+                ctx.collector->finishChunk(strand.chip_index, segment.chunk_meta);
+            }
+            strand.words.pop(segment.words);
+            strand.segments.pop(1);
+            decoded += segment.words + (segment.chunk_end ? 1 : 0);
+            since_publish += segment.words;
+            if (since_publish >= PUBLISH_CHECK_WORDS) {
+                publishIfRequested(data);  // Long backlogs do not delay reports
+                since_publish = 0;
+            }
+        }
+
+        if (strand.pending_segments.fetch_sub(segments, std::memory_order_acq_rel) != segments) {
+            // Bottom of our deque: likely run next by us, stealable by idle workers
+            if (data.deque.push(&strand)) {
+                wakeWorkers(1);
+            } else {
+                inject(strand);
+            }
+        }
+
+        size_t remaining = pending_tasks_.fetch_sub(decoded, std::memory_order_acq_rel) - decoded;
+        if (remaining == 0) {
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                idle_cv_.notify_all();
+            }
+            if (stop_.load(std::memory_order_acquire)) {
+                wakeWorkers(static_cast<int>(worker_data_.size()));
+            }
+        }
+    }
+
+    void processWord(uint64_t word, uint8_t chip_index, const ChunkMetadata& meta, WorkerData& data,
+                     const DecodeContext& ctx) {
+        PartialStats& stats = data.stats;
+        uint8_t full_type = (word >> 56) & 0xFF;
+        if (full_type == SPIDR_PACKET_ID || full_type == TPX3_CONTROL ||
+            full_type == EXTRA_TIMESTAMP || full_type == EXTRA_TIMESTAMP_MPX3 ||
+            full_type == GLOBAL_TIME_LOW || full_type == GLOBAL_TIME_HIGH) {
+            process_packet(word, chip_index, processor_, meta, true, ctx);
+            return;
+        }
+        uint8_t packet_type = (word >> 60) & 0xF;
+        switch (packet_type) {
+            case PIXEL_COUNT_FB:
+            case PIXEL_STANDARD: {
+                if (ctx.mask && ctx.mask->reject(chip_index, word)) {
+                    break;
+                }
+                try {
+                    PixelHit hit = decode_pixel_data(word, chip_index);
+                    if (meta.has_extra_packets) {
+                        uint64_t truncated_toa = hit.toa_ns & 0x3FFFFFFF;
+                        hit.toa_ns =
+                            extend_timestamp(truncated_toa, meta.min_timestamp_ns, 30);
+                    } else if (extender_) {
+                        hit.toa_ns = extender_->extendPixel(hit.chip_index, hit.toa_ns);
+                    }
+                    if (ctx.collector) {
+                        ctx.collector->add(hit);
+                    }
+                    stats.hits++;
+                    if (hit.chip_index < stats.chip_hits.size()) {
+                        stats.chip_hits[hit.chip_index]++;
+                    } else {
+                        stats.chip_out_of_range++;
+                    }
+                    stats.earliest_hit_tick =
+                        std::min(stats.earliest_hit_tick, hit.toa_ns);
+                    stats.latest_hit_tick =
+                        std::max(stats.latest_hit_tick, hit.toa_ns);
+                    if (recent_capacity_ > 0 &&
+                        stats.recent_hits.size() < recent_capacity_) {
+                        stats.recent_hits.push_back(hit);
+                    }
+                } catch (...) {
+                    process_packet(word, chip_index, processor_, meta, true, ctx);
+                }
+                break;
+            }
+            case TDC_DATA: {
+                try {
+                    TDCEvent tdc = decode_tdc_data(word);
+                    if (extender_) {
+                        tdc.timestamp_ns = extender_->extendTdc(chip_index, tdc.timestamp_ns);
+                    }
+                    if (ctx.tdc1_history && tdc.type == TDC1_RISE) {
+                        ctx.tdc1_history->record(chip_index, tdc.timestamp_ns);
+                    }
+                    bool chip_in_range = chip_index < stats.chip_tdc1.size();
+                    if (tdc.type == TDC1_RISE || tdc.type == TDC1_FALL) {
+                        stats.tdc1++;
+                        stats.earliest_tdc1_tick =
+                            std::min(stats.earliest_tdc1_tick, tdc.timestamp_ns);
+                        stats.latest_tdc1_tick =
+                            std::max(stats.latest_tdc1_tick, tdc.timestamp_ns);
+                        if (chip_in_range) {
+                            stats.chip_tdc1[chip_index]++;
+                            stats.chip_tdc1_min[chip_index] =
+                                std::min(stats.chip_tdc1_min[chip_index], tdc.timestamp_ns);
+                            stats.chip_tdc1_max[chip_index] =
+                                std::max(stats.chip_tdc1_max[chip_index], tdc.timestamp_ns);
+                        } else {
+                            stats.chip_out_of_range++;
+                        }
+                    } else if (tdc.type == TDC2_RISE || tdc.type == TDC2_FALL) {
+                        stats.tdc2++;
+                        if (chip_in_range) {
+                            stats.chip_tdc2[chip_index]++;
+                        } else {
+                            stats.chip_out_of_range++;
+                        }
+                    }
+                } catch (...) {
+                    process_packet(word, chip_index, processor_, meta, true, ctx);
+                }
+                break;
+            }
+            default:
+                process_packet(word, chip_index, processor_, meta, true, ctx);
+                break;
+        }
+    }
+
+    // Reporting side: merge every published outbox into the HitProcessor. An
+    // outbox claimed by another reporter is waited for, so that a true
+    // statisticsPublished() means the statistics are visible.
+    void collectPublished() {
+        for (auto& data : worker_data_) {
+            int state = OUTBOX_FULL;
+            if (data->outbox_state.compare_exchange_strong(state, OUTBOX_MERGING, std::memory_order_acquire)) {
+                data->outbox.mergeInto(processor_);
+                data->outbox.reset(recent_capacity_, chip_count_);
+                data->outbox_state.store(OUTBOX_EMPTY, std::memory_order_release);
+            } else {
+                while (data->outbox_state.load(std::memory_order_acquire) == OUTBOX_MERGING) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+};
+
+// Frame and decode a buffer of whole 8-byte words. Chunk state carries over
+// between calls, so a stream may be fed in arbitrary word-aligned pieces.
+// With a dispatcher and state.dispatch_policy, words are decoded inline or
+// dispatched per state.decode_mode, which follows the policy at chunk headers.
+void process_raw_data(const uint8_t* buffer, size_t bytes, HitProcessor& processor, StreamState& state,
+                      DecodeDispatcher* dispatcher, PacketReorderBuffer* reorder_buffer = nullptr,
+                      bool enable_accounting = true);
+
+#endif // DECODE_PIPELINE_H
@@ -0,0 +1,103 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef DISPATCH_POLICY_H
+#define DISPATCH_POLICY_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// How the processing thread hands decoded words on
+enum class DecodeMode {
+    Inline,   // Decode on the processing thread (no dispatcher overhead)
+    Parallel  // Submit to the DecodeDispatcher workers
+};
+
+const char* decode_mode_name(DecodeMode mode);
+
+/**
+ * Chooses between inline decode and parallel dispatch from measured load.
+ * The processing thread reports every buffer: the time spent in
+ * process_raw_data, its word count and the raw queue depth left behind.
+ * Over each window the policy computes the busy fraction of the processing
+ * thread. Inline decode switches to parallel when that fraction (or the raw
+ * queue) crosses the high mark; parallel dispatch switches back when the
+ * inline cost per word measured earlier, applied to the current word rate,
+ * projects a busy fraction below the low mark. A minimum dwell time keeps
+ * the mode from flapping.
+ *
+ * The policy only decides; process_raw_data applies the change at the next
+ * chunk boundary and calls applied(). Not thread-safe: processing thread only.
+ */
+class DispatchPolicy {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Config {
+        double parallel_load = 0.6;    // Inline busy fraction that switches to parallel
+        double inline_load = 0.25;     // Projected inline busy fraction that switches back
+        size_t queue_high = 4;         // Raw buffers queued behind the current one: switch to parallel now
+        std::chrono::milliseconds window{100};
+        std::chrono::milliseconds min_dwell{500};
+    };
+
+    // A mode change as applied at a chunk boundary
+    struct Switch {
+        DecodeMode mode = DecodeMode::Inline;
+        double load = 0.0;         // Busy fraction (measured inline, projected for parallel -> inline)
+        size_t queue_depth = 0;    // Largest raw queue depth in the deciding window
+    };
+
+    explicit DispatchPolicy(DecodeMode initial = DecodeMode::Inline);
+    DispatchPolicy(DecodeMode initial, const Config& config);
+
+    // After each buffer: decode time, words in the buffer, raw buffers still queued
+    void recordBuffer(Clock::time_point start, Clock::time_point end, size_t words, size_t queue_depth);
+
+    DecodeMode desired() const { return desired_; }
+    DecodeMode current() const { return current_; }
+
+    // Called by the pipeline once the desired mode is in effect
+    void applied(DecodeMode mode);
+
+    // Switches not yet reported; returns the latest one and clears the flag
+    bool takeSwitch(Switch& latest);
+
+    uint64_t switches() const { return switches_; }
+    uint64_t inlineWords() const { return inline_words_; }
+    uint64_t parallelWords() const { return parallel_words_; }
+    double inlineNsPerWord() const { return inline_ns_per_word_; }
+    // One-line summary for the final statistics
+    std::string describe() const;
+
+private:
+    void evaluate(uint64_t now_ns);
+
+    Config config_;
+    DecodeMode desired_;
+    DecodeMode current_;
+    Switch pending_{};
+    Switch latest_{};
+    bool unreported_ = false;
+
+    // Current window
+    uint64_t window_start_ns_ = 0;
+    uint64_t busy_ns_ = 0;
+    uint64_t words_ = 0;
+    size_t max_queue_depth_ = 0;
+
+    uint64_t last_switch_ns_ = 0;  // 0: the first switch needs no dwell
+    double inline_ns_per_word_ = 0.0;  // Smoothed over inline windows; 0 until measured
+    uint64_t switches_ = 0;
+    uint64_t inline_words_ = 0;
+    uint64_t parallel_words_ = 0;
+};
+
+#endif // DISPATCH_POLICY_H
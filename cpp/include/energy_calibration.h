@@ -0,0 +1,102 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef ENERGY_CALIBRATION_H
+#define ENERGY_CALIBRATION_H
+
+#include "hit_block.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Per-pixel ToT-to-energy calibration.
+ *
+ * Uses the standard Timepix surrogate function
+ *     ToT(E) = a*E + b - c / (E - t)
+ * with ToT in 25 ns clock counts and E in keV. Its inverse is
+ *     E = (ToT - (b - a*t) + sqrt((ToT - (b + a*t))^2 + 4*a*c)) / (2*a)
+ * so each pixel's (a, b, c, t) is stored pre-folded into four coefficient
+ * tables (65536 entries per chip, structure-of-arrays). Uncalibrated pixels
+ * (and pixels of chips without a table) have a NaN scale, so their energy is
+ * NaN, never 0: consumers must test with std::isnan (EnergySpectrum counts
+ * such hits as uncalibrated and leaves them out of the spectrum).
+ *
+ * Calibration file format (text, one pixel per line, '#' starts a comment):
+ *     chip x y a b c t
+ */
+class EnergyCalibration {
+public:
+    static constexpr size_t PIXELS_PER_CHIP = 65536;
+    static constexpr float TOT_NS_PER_COUNT = 25.0f;
+
+    // Per-thread buffers for apply()
+    struct Scratch {
+        std::vector<float> tot;
+        std::vector<float> offset;
+        std::vector<float> center;
+        std::vector<float> discriminant;
+        std::vector<float> scale;
+    };
+
+    EnergyCalibration();
+
+    // Returns false and sets `error` on I/O or parse failure
+    bool loadFromFile(const std::string& path, std::string& error);
+
+    // Set one pixel (returns false if the parameters are outside the
+    // surrogate function's valid domain: a > 0, c >= 0)
+    bool setPixel(uint8_t chip, uint16_t x, uint16_t y, float a, float b, float c, float t);
+
+    // Fill block.energy for every hit in the block (NaN for uncalibrated pixels)
+    void apply(HitBlock& block, Scratch& scratch) const;
+
+    size_t calibratedPixels() const { return calibrated_pixels_; }
+    size_t calibratedChips() const;
+    size_t rejectedPixels() const { return rejected_pixels_; }
+
+private:
+    struct ChipTable {
+        std::vector<float> offset;        // b - a*t
+        std::vector<float> center;        // b + a*t
+        std::vector<float> discriminant;  // 4*a*c
+        std::vector<float> scale;         // 1 / (2*a), NaN if uncalibrated
+    };
+
+    static size_t pixelIndex(uint16_t x, uint16_t y) { return (static_cast<size_t>(y) << 8) | x; }
+
+    std::vector<ChipTable> chips_;  // Indexed by 8-bit chip index, empty until a pixel is set
+    size_t calibrated_pixels_;
+    size_t rejected_pixels_;
+};
+
+/**
+ * Online energy spectrum and energy-weighted centroids of calibrated hits.
+ * One instance per decoding thread; merge() combines them for reporting.
+ */
+struct EnergySpectrum {
+    double bin_width_kev = 1.0;
+    std::vector<uint64_t> bins;          // Last bin collects overflow
+    std::vector<double> chip_energy_kev; // Per chip (indexed by 8-bit chip index)
+    std::vector<double> chip_weighted_x;
+    std::vector<double> chip_weighted_y;
+    std::vector<uint64_t> chip_hits;
+    uint64_t uncalibrated_hits = 0;
+
+    void configure(size_t bin_count, double bin_width);
+    void add(const HitBlock& block);
+    void merge(const EnergySpectrum& other);
+
+    uint64_t totalHits() const;
+
+    // Write "energy_kev,count" CSV (bin lower edges). Returns false on I/O error.
+    bool writeCsv(const std::string& path) const;
+};
+
+#endif // ENERGY_CALIBRATION_H
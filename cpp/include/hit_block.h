@@ -0,0 +1,148 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef HIT_BLOCK_H
+#define HIT_BLOCK_H
+
+#include "tpx3_packets.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+/**
+ * Structure-of-arrays block of decoded pixel hits.
+ *
+ * Block stages (sorting, merging, corrections) run tight loops over
+ * individual columns, so each field is kept in its own contiguous array.
+ */
+struct HitBlock {
+    std::vector<uint64_t> toa;       // Extended ToA in 1.5625ns units
+    std::vector<uint16_t> x;
+    std::vector<uint16_t> y;
+    std::vector<uint16_t> tot;       // ToT in ns
+    std::vector<uint8_t> chip;
+    std::vector<uint8_t> count_fb;   // 1 if decoded from a count_fb packet
+    std::vector<float> energy;       // Deposited energy in keV (NaN until calibrated)
+    
+    size_t size() const { return toa.size(); }
+    bool empty() const { return toa.empty(); }
+    
+    void clear() {
+        toa.clear();
+        x.clear();
+        y.clear();
+        tot.clear();
+        chip.clear();
+        count_fb.clear();
+        energy.clear();
+    }
+    
+    void reserve(size_t n) {
+        toa.reserve(n);
+        x.reserve(n);
+        y.reserve(n);
+        tot.reserve(n);
+        chip.reserve(n);
+        count_fb.reserve(n);
+        energy.reserve(n);
+    }
+    
+    void push_back(const PixelHit& hit) {
+        toa.push_back(hit.toa_ns);
+        x.push_back(hit.x);
+        y.push_back(hit.y);
+        tot.push_back(hit.tot_ns);
+        chip.push_back(hit.chip_index);
+        count_fb.push_back(hit.is_count_fb ? 1 : 0);
+        energy.push_back(std::numeric_limits<float>::quiet_NaN());
+    }
+    
+    // Append hit `i` of another block
+    void push_back(const HitBlock& other, size_t i) {
+        toa.push_back(other.toa[i]);
+        x.push_back(other.x[i]);
+        y.push_back(other.y[i]);
+        tot.push_back(other.tot[i]);
+        chip.push_back(other.chip[i]);
+        count_fb.push_back(other.count_fb[i]);
+        energy.push_back(other.energy[i]);
+    }
+    
+    PixelHit at(size_t i) const {
+        PixelHit hit;
+        hit.x = x[i];
+        hit.y = y[i];
+        hit.toa_ns = toa[i];
+        hit.tot_ns = tot[i];
+        hit.chip_index = chip[i];
+        hit.is_count_fb = count_fb[i] != 0;
+        return hit;
+    }
+    
+    // Reorder all columns so that new[i] = old[order[i]]
+    void permute(const std::vector<uint32_t>& order) {
+        gather(toa, order);
+        gather(x, order);
+        gather(y, order);
+        gather(tot, order);
+        gather(chip, order);
+        gather(count_fb, order);
+        gather(energy, order);
+    }
+    
+    // Keep hits with keep[i] != 0 (in order); returns the new size
+    size_t compact(const std::vector<uint8_t>& keep) {
+        compactColumn(toa, keep);
+        compactColumn(x, keep);
+        compactColumn(y, keep);
+        compactColumn(tot, keep);
+        compactColumn(chip, keep);
+        compactColumn(count_fb, keep);
+        compactColumn(energy, keep);
+        return size();
+    }
+    
+private:
+    // Branch-free stream compaction: always write, advance only for kept hits
+    template <typename T>
+    static void compactColumn(std::vector<T>& column, const std::vector<uint8_t>& keep) {
+        size_t out = 0;
+        for (size_t i = 0; i < column.size(); ++i) {
+            column[out] = column[i];
+            out += keep[i] != 0;
+        }
+        column.resize(out);
+    }
+    
+    template <typename T>
+    static void gather(std::vector<T>& column, const std::vector<uint32_t>& order) {
+        std::vector<T> sorted(column.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            sorted[i] = column[order[i]];
+        }
+        column.swap(sorted);
+    }
+};
+
+// Stable sort of a block by ToA (comparison sort on an index permutation)
+inline void sort_hits_by_toa(HitBlock& block) {
+    if (block.size() < 2 || std::is_sorted(block.toa.begin(), block.toa.end())) {
+        return;
+    }
+    std::vector<uint32_t> order(block.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&block](uint32_t a, uint32_t b) {
+        return block.toa[a] < block.toa[b];
+    });
+    block.permute(order);
+}
+
+#endif // HIT_BLOCK_H
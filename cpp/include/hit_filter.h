@@ -0,0 +1,133 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef HIT_FILTER_H
+#define HIT_FILTER_H
+
+#include "hit_block.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Recent TDC1 rising-edge timestamps (extended, 1.5625ns units) shared
+ * between decoding threads: the thread decoding the TDC chip records, the
+ * threads filtering hit blocks of every chip read.
+ *
+ * Only the chip of the first TDC1 is recorded, so there is a single writer
+ * and the ring is in time order (binary-searchable). It holds 4096 pulses
+ * (68 s at 60 Hz), enough for workers drifting apart in data time.
+ *
+ * The horizon is the data time up to which the history is complete: the
+ * newest timestamp decoded on the TDC chip.
+ */
+class Tdc1History {
+public:
+    static constexpr size_t CAPACITY = 4096;
+    static constexpr int NO_SOURCE_CHIP = -1;
+
+    void record(uint8_t chip, uint64_t timestamp) {
+        int source = NO_SOURCE_CHIP;
+        if (!source_chip_.compare_exchange_strong(source, chip, std::memory_order_relaxed) &&
+            source != chip) {
+            return;
+        }
+        uint64_t index = count_.load(std::memory_order_relaxed);
+        entries_[index % CAPACITY].store(timestamp, std::memory_order_relaxed);
+        count_.store(index + 1, std::memory_order_release);
+        advanceHorizon(chip, timestamp);
+    }
+
+    // Called with the progress of each decoded chunk; only the TDC chip counts
+    void advanceHorizon(uint8_t chip, uint64_t timestamp) {
+        if (chip != source_chip_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        uint64_t current = horizon_.load(std::memory_order_relaxed);
+        while (timestamp > current &&
+               !horizon_.compare_exchange_weak(current, timestamp, std::memory_order_release)) {
+        }
+    }
+
+    uint64_t horizon() const { return horizon_.load(std::memory_order_acquire); }
+
+    // Recorded timestamps that can be the reference of a hit in [begin, end]:
+    // the latest one before `begin` and all in [begin, end], ascending
+    void snapshot(uint64_t begin, uint64_t end, std::vector<uint64_t>& out) const;
+
+private:
+    std::array<std::atomic<uint64_t>, CAPACITY> entries_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> horizon_{0};
+    std::atomic<int> source_chip_{NO_SOURCE_CHIP};
+};
+
+/**
+ * Hit block filter: rectangular regions of interest per chip, a ToT window
+ * and a time-of-flight window (ToA relative to the latest TDC1 rising edge).
+ *
+ * Each criterion is evaluated over whole columns into a keep mask with
+ * branch-free compares, then all columns are compacted in one pass, so hits
+ * outside the filter never reach calibration, sorting or the merge stage.
+ *
+ * With a ToF window, a block should only be filtered once its newest hit is
+ * behind the TDC1 history horizon (see ChunkHitCollector); otherwise hits
+ * of other chips right after a pulse are matched to the previous TDC1.
+ */
+class HitFilter {
+public:
+    struct Roi {
+        uint16_t x_min, y_min, x_max, y_max;  // Inclusive
+    };
+
+    struct Statistics {
+        uint64_t hits_in = 0;
+        uint64_t roi_rejected = 0;
+        uint64_t tot_rejected = 0;
+        uint64_t tof_rejected = 0;  // Outside the window or before the first TDC1
+        uint64_t hits_passed = 0;
+
+        void merge(const Statistics& other);
+    };
+
+    // Per-thread buffers for apply()
+    struct Scratch {
+        std::vector<uint8_t> keep;
+        std::vector<uint8_t> inside;
+        std::vector<uint64_t> tdc1;
+    };
+
+    HitFilter();
+
+    // Once any ROI is set, hits of chips without an ROI are rejected
+    void addRoi(uint8_t chip, const Roi& roi);
+    void setTotWindow(uint16_t min_ns, uint16_t max_ns);
+    void setTofWindow(uint64_t min_ticks, uint64_t max_ticks);
+
+    bool enabled() const { return has_roi_ || has_tot_ || has_tof_; }
+    bool usesTdc1() const { return has_tof_; }
+    Tdc1History& tdc1History() { return tdc1_; }
+
+    // Remove rejected hits from the block (order of kept hits is preserved)
+    void apply(HitBlock& block, Scratch& scratch, Statistics& stats) const;
+
+private:
+    std::vector<std::vector<Roi>> rois_;  // Indexed by 8-bit chip index
+    bool has_roi_;
+    bool has_tot_;
+    bool has_tof_;
+    uint16_t tot_min_ns_;
+    uint16_t tot_max_ns_;
+    uint64_t tof_min_ticks_;
+    uint64_t tof_max_ticks_;
+    Tdc1History tdc1_;
+};
+
+#endif // HIT_FILTER_H
@@ -12,7 +12,6 @@
 #include "tpx3_packets.h"
 #include <vector>
 #include <cstdint>
-#include <array>
 #include <map>
 #include <string>
 #include <limits>
@@ -35,12 +34,14 @@ struct Statistics {
     double cumulative_hit_rate_hz;  // Cumulative average: total_hits / elapsed_time
     double cumulative_tdc1_rate_hz;  // Cumulative average: total_tdc1_events / elapsed_time
     double cumulative_tdc2_rate_hz;  // Cumulative average: total_tdc2_events / elapsed_time
-    std::array<double, 4> chip_hit_rates_hz;
-    std::array<bool, 4> chip_hit_rate_valid;
-    std::array<uint64_t, 4> chip_tdc1_counts;
-    std::array<double, 4> chip_tdc1_rates_hz;
-    std::array<double, 4> chip_tdc1_cumulative_rates_hz;
-    std::array<bool, 4> chip_tdc1_present;
+    // Per-chip tables are sized to HitProcessor::chipCount()
+    std::vector<double> chip_hit_rates_hz;
+    std::vector<bool> chip_hit_rate_valid;
+    std::vector<uint64_t> chip_tdc1_counts;
+    std::vector<double> chip_tdc1_rates_hz;
+    std::vector<double> chip_tdc1_cumulative_rates_hz;
+    std::vector<bool> chip_tdc1_present;
+    uint64_t chip_index_out_of_range;  // Hits/TDC events with chip index >= chip count
     std::map<std::string, uint64_t> packet_byte_totals; // Bytes accounted per packet category
     uint64_t total_bytes_accounted;  // Total bytes accounted across all categories
     uint64_t earliest_hit_time_ticks;
@@ -58,7 +59,12 @@ struct Statistics {
 
 class HitProcessor {
 public:
-    HitProcessor();
+    // Default matches a single quad (2x2) Timepix3 module
+    static constexpr size_t DEFAULT_CHIP_COUNT = 4;
+    // Chunk headers carry an 8-bit chip index
+    static constexpr size_t MAX_CHIP_COUNT = 256;
+
+    explicit HitProcessor(size_t chip_count = DEFAULT_CHIP_COUNT);
     
     void addHit(const PixelHit& hit);
     void addTdcEvent(const TDCEvent& tdc, uint8_t chip_index);
@@ -75,6 +81,10 @@ public:
                             uint64_t packets_dropped_too_old);
     void addPacketBytes(const std::string& category, uint64_t bytes);
     
+    // Resize per-chip counters (resets statistics)
+    void setChipCount(size_t chip_count);
+    size_t chipCount() const { return chip_count_; }
+    
     void setRecentHitCapacity(size_t capacity);
     std::vector<PixelHit> getRecentHits() const;
     std::vector<PixelHit> getHits() const { return getRecentHits(); } // Legacy compatibility
@@ -88,6 +98,7 @@ public:
     
 private:
     friend class DecodeDispatcher;
+    size_t chip_count_;
     size_t recent_hit_capacity_;
     std::vector<PixelHit> recent_hits_buffer_;
     size_t recent_hits_head_;
@@ -99,11 +110,11 @@ private:
     uint64_t hits_at_last_update_;
     uint64_t tdc1_events_at_last_update_;
     uint64_t tdc2_events_at_last_update_;
-    std::array<uint64_t, 4> chip_hit_totals_;
-    std::array<uint64_t, 4> chip_hits_at_last_update_;
-    std::array<uint64_t, 4> chip_tdc1_at_last_update_;
-    std::array<uint64_t, 4> chip_tdc1_min_ticks_;
-    std::array<uint64_t, 4> chip_tdc1_max_ticks_;
+    std::vector<uint64_t> chip_hit_totals_;
+    std::vector<uint64_t> chip_hits_at_last_update_;
+    std::vector<uint64_t> chip_tdc1_at_last_update_;
+    std::vector<uint64_t> chip_tdc1_min_ticks_;
+    std::vector<uint64_t> chip_tdc1_max_ticks_;
     uint64_t calls_since_last_update_;
     uint64_t last_hit_time_ticks_;
     uint64_t last_tdc1_time_ticks_;
@@ -0,0 +1,35 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef HIT_SORT_H
+#define HIT_SORT_H
+
+#include "hit_block.h"
+#include <cstdint>
+#include <vector>
+
+// Reusable buffers for radix_sort_hits_by_toa (one per sorting thread)
+struct HitSortScratch {
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> temp;
+    std::vector<uint32_t> order;
+};
+
+/**
+ * Stable sort of a block by extended ToA using an LSD radix sort.
+ *
+ * Keys are taken relative to the block's minimum ToA, so a chunk spanning
+ * less than 2^32 ticks (~6.7 s) needs only as many 11-bit passes as its
+ * range requires (3 passes for the usual ~30 bits); passes whose digit is
+ * constant are skipped. Already sorted blocks are detected in the min/max
+ * scan and left untouched. Small blocks and blocks with a wider range fall
+ * back to sort_hits_by_toa().
+ */
+void radix_sort_hits_by_toa(HitBlock& block, HitSortScratch& scratch);
+
+#endif // HIT_SORT_H
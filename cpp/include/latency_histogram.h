@@ -0,0 +1,98 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Log-bucket latency histogram in nanoseconds (HDR-style): each power of two
+ * is split into 8 linear sub-buckets, so any value is placed within 12.5%
+ * over the full 64-bit range with a fixed 496-bucket table.
+ *
+ * Single writer: record() is only called by the thread owning the
+ * histogram, and uses plain relaxed load/store (no locked RMW). Other
+ * threads may take a snapshot() at any time; a concurrent snapshot can miss
+ * the values being recorded but never sees torn counters.
+ */
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 3;
+    static constexpr size_t SUB_BUCKETS = 1 << SUB_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    struct Snapshot {
+        std::vector<uint64_t> counts;  // BUCKETS entries (empty until merged into)
+        uint64_t count = 0;
+        uint64_t sum_ns = 0;
+        uint64_t max_ns = 0;
+
+        void merge(const Snapshot& other);
+        double meanNs() const { return count ? static_cast<double>(sum_ns) / static_cast<double>(count) : 0.0; }
+        // Upper bound of the bucket holding the given quantile (0..1)
+        uint64_t percentileNs(double quantile) const;
+    };
+
+    void record(uint64_t ns) {
+        relaxedIncrement(counts_[bucketIndex(ns)], 1);
+        relaxedIncrement(sum_ns_, ns);
+        if (ns > max_ns_.load(std::memory_order_relaxed)) {
+            max_ns_.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    void recordSince(std::chrono::steady_clock::time_point start) {
+        record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count()));
+    }
+
+    Snapshot snapshot() const;
+
+    static size_t bucketIndex(uint64_t ns) {
+        if (ns < SUB_BUCKETS) {
+            return static_cast<size_t>(ns);
+        }
+        int exponent = 63 - __builtin_clzll(ns);
+        size_t sub = static_cast<size_t>(ns >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1);
+        return static_cast<size_t>(exponent - SUB_BITS + 1) * SUB_BUCKETS + sub;
+    }
+    static uint64_t bucketUpperNs(size_t index);
+
+private:
+    static void relaxedIncrement(std::atomic<uint64_t>& counter, uint64_t amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> counts_{};
+    std::atomic<uint64_t> sum_ns_{0};
+    std::atomic<uint64_t> max_ns_{0};
+};
+
+/**
+ * Latency of each ingest stage, one histogram per recording thread:
+ * recv to enqueue (network thread), queue wait and process_raw_data per
+ * buffer (processing thread). Decoder task latency (batch submission to
+ * decode start) is kept per worker by DecodeDispatcher.
+ */
+struct PipelineLatency {
+    LatencyHistogram recv_to_enqueue;
+    LatencyHistogram queue_wait;
+    LatencyHistogram process_buffer;
+};
+
+// One line per stage: count, mean, p50/p90/p99/p99.9 and max in microseconds
+void print_latency_line(const std::string& label, const LatencyHistogram::Snapshot& snapshot);
+
+#endif // LATENCY_HISTOGRAM_H
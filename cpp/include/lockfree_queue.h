@@ -0,0 +1,178 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef LOCKFREE_QUEUE_H
+#define LOCKFREE_QUEUE_H
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+
+/**
+ * Bounded single-producer / single-consumer ring. Items are pushed in
+ * groups and consumed in place (at(), then pop(count)), so a consumer can
+ * drain a batch with one release store. The consumer role may move between
+ * threads as long as the hand-off itself synchronizes.
+ */
+template <typename T>
+class SpscRing {
+public:
+    // Power-of-two capacity; call before use
+    void reserve(size_t capacity) {
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        slots_.reset(new T[rounded]);
+        mask_ = rounded - 1;
+    }
+
+    bool allocated() const { return slots_ != nullptr; }
+    size_t capacity() const { return mask_ + 1; }
+    const T* data() const { return slots_.get(); }
+    size_t bytes() const { return allocated() ? capacity() * sizeof(T) : 0; }
+
+    // Write every slot, so its pages are faulted in on the calling thread's node
+    void prefault() {
+        for (size_t i = 0; i < capacity(); ++i) {
+            slots_[i] = T{};
+        }
+    }
+
+    // Producer: all `count` items or none
+    bool tryPush(const T* items, size_t count) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t head = head_.load(std::memory_order_acquire);
+        if (capacity() - (tail - head) < count) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            slots_[(tail + i) & mask_] = items[i];
+        }
+        tail_.store(tail + count, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer
+    size_t available() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_relaxed);
+    }
+    const T& at(size_t offset) const { return slots_[(head_.load(std::memory_order_relaxed) + offset) & mask_]; }
+    void pop(size_t count) {
+        head_.store(head_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+private:
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    std::unique_ptr<T[]> slots_;
+    size_t mask_ = 0;
+};
+
+/**
+ * Bounded multi-producer / multi-consumer queue (Vyukov): one CAS per
+ * operation, per-slot sequence numbers instead of a lock.
+ */
+template <typename T>
+class MpmcQueue {
+public:
+    explicit MpmcQueue(size_t capacity) {
+        size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded <<= 1;
+        }
+        cells_.reset(new Cell[rounded]);
+        for (size_t i = 0; i < rounded; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        mask_ = rounded - 1;
+    }
+
+    bool tryPush(const T& item) {
+        size_t position = enqueue_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[position & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (diff == 0) {
+                if (enqueue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.item = item;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // Full
+            } else {
+                position = enqueue_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& item) {
+        size_t position = dequeue_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[position & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+            if (diff == 0) {
+                if (dequeue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    item = cell.item;
+                    cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // Empty
+            } else {
+                position = dequeue_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Approximate
+    bool empty() const {
+        return dequeue_.load(std::memory_order_acquire) >= enqueue_.load(std::memory_order_acquire);
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> enqueue_{0};
+    alignas(64) std::atomic<size_t> dequeue_{0};
+};
+
+// Sleep while *word == expected (bounded by timeout_ms; spurious wake-ups allowed)
+inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, long timeout_ms) {
+    timespec timeout{timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, &timeout, nullptr, 0);
+}
+
+inline void futex_wake(std::atomic<uint32_t>& word, int waiters) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, waiters, nullptr, nullptr, 0);
+}
+
+// Spin-wait hint
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+#endif // LOCKFREE_QUEUE_H
@@ -0,0 +1,96 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include "hit_processor.h"
+#include "latency_histogram.h"
+#include "queue_telemetry.h"
+
+#include <cstdint>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Prometheus text exposition format (version 0.0.4) builder.
+ */
+class PrometheusWriter {
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    // HELP/TYPE header; emit once per metric name before its samples
+    void family(const std::string& name, const std::string& type, const std::string& help);
+    void sample(const std::string& name, double value, const Labels& labels = {});
+
+    std::string str() const { return out_.str(); }
+
+private:
+    std::ostringstream out_;
+};
+
+void append_statistics_metrics(PrometheusWriter& writer, const Statistics& stats);
+// One summary (quantiles, _sum, _count in seconds) per pipeline stage
+void append_latency_metrics(PrometheusWriter& writer,
+                            const std::vector<std::pair<std::string, LatencyHistogram::Snapshot>>& stages);
+void append_queue_metrics(PrometheusWriter& writer, const std::vector<QueueTelemetry::Summary>& queues);
+
+/**
+ * Minimal single-threaded HTTP/1.0 server (epoll, non-blocking sockets) for
+ * Prometheus scrapes. GET /metrics returns the text produced by the render
+ * function, which runs on the server thread; every connection is closed
+ * after its response.
+ */
+class MetricsServer {
+public:
+    using RenderFn = std::function<std::string()>;
+
+    MetricsServer(const std::string& host, uint16_t port, RenderFn render);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    bool start(std::string& error);
+    void stop();
+
+    uint64_t requestsServed() const { return requests_served_; }
+
+private:
+    static constexpr size_t MAX_REQUEST_BYTES = 8192;
+    static constexpr int MAX_CONNECTIONS = 64;
+
+    struct Connection {
+        std::string request;
+        std::string response;
+        size_t sent = 0;
+    };
+
+    void serverLoop();
+    void acceptConnections();
+    void handleReadable(int fd, Connection& connection);
+    bool flushResponse(int fd, Connection& connection);  // False once finished or failed
+    void closeConnection(int fd);
+    std::string buildResponse(const std::string& request);
+
+    std::string host_;
+    uint16_t port_;
+    RenderFn render_;
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;  // eventfd to stop the loop
+    std::unordered_map<int, Connection> connections_;
+    uint64_t requests_served_ = 0;
+    std::thread thread_;
+};
+
+#endif // METRICS_SERVER_H
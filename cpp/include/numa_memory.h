@@ -0,0 +1,108 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef NUMA_MEMORY_H
+#define NUMA_MEMORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// NUMA node of the CPU the calling thread runs on (-1 when unknown)
+int current_numa_node();
+
+// Page backing of a NodeMemory mapping
+enum class HugePages {
+    Off,          // Base pages
+    Transparent,  // MADV_HUGEPAGE (THP), best effort
+    Huge2M,       // MAP_HUGETLB 2 MB pages, falling back to THP
+    Huge1G        // MAP_HUGETLB 1 GB pages, falling back to 2 MB, then THP
+};
+
+// "off", "thp", "2m" or "1g"; false on anything else
+bool parse_huge_pages(const std::string& text, HugePages& mode);
+
+// mlock / munlock an arbitrary range (the pages containing it)
+bool lock_memory(const void* data, size_t bytes, std::string& error);
+void unlock_memory(const void* data, size_t bytes);
+
+/**
+ * Anonymous memory mapping placed on one NUMA node. The node policy is set
+ * with mbind(2) (raw syscall, no libnuma) before any page is touched, so
+ * pages land on the node no matter which thread writes them first.
+ * Explicit huge pages come from the hugetlb pool (vm.nr_hugepages); when
+ * none are reserved the mapping falls back to transparent huge pages.
+ */
+class NodeMemory {
+public:
+    NodeMemory() = default;
+    ~NodeMemory() { release(); }
+
+    NodeMemory(const NodeMemory&) = delete;
+    NodeMemory& operator=(const NodeMemory&) = delete;
+
+    // node < 0 leaves placement to the kernel (first touch). False if the
+    // mapping fails; if only mbind fails, error is set and true is returned
+    bool allocate(size_t bytes, int node, HugePages pages, std::string& error);
+    void release();
+
+    // Touch every page now so no fault is taken on the data path
+    void prefault();
+    // mlock the mapping (needs RLIMIT_MEMLOCK or CAP_IPC_LOCK)
+    bool lock(std::string& error);
+
+    uint8_t* data() const { return data_; }
+    size_t size() const { return bytes_; }
+    int node() const { return node_bound_ ? node_ : -1; }
+    size_t pageBytes() const { return page_bytes_; }  // hugetlb or base page size
+    bool hugetlb() const { return hugetlb_; }
+    bool hugePagesAdvised() const { return huge_advised_; }
+    bool locked() const { return locked_; }
+    bool prefaulted() const { return prefaulted_; }
+    // Placement description for startup output, e.g. "NUMA node 1, 2 MB huge pages, locked"
+    std::string describe() const;
+
+private:
+    uint8_t* data_ = nullptr;
+    size_t bytes_ = 0;
+    size_t page_bytes_ = 0;
+    int node_ = -1;
+    bool node_bound_ = false;
+    bool hugetlb_ = false;
+    bool huge_advised_ = false;
+    bool prefaulted_ = false;
+    bool locked_ = false;
+};
+
+/**
+ * Fixed-size slots carved from one NodeMemory region. Not synchronized: the
+ * owner (RawDataQueue) calls acquire/release under its own lock. Free slots
+ * are reused LIFO so the recently touched ones stay hot.
+ */
+class BufferPool {
+public:
+    bool allocate(size_t slot_bytes, size_t slot_count, int node, HugePages pages, std::string& error);
+
+    size_t slotBytes() const { return slot_bytes_; }
+    size_t slotCount() const { return slot_count_; }
+    size_t freeSlots() const { return free_.size(); }
+    NodeMemory& memory() { return memory_; }
+    const NodeMemory& memory() const { return memory_; }
+
+    uint8_t* acquire();  // nullptr when exhausted
+    void release(uint8_t* slot);
+
+private:
+    NodeMemory memory_;
+    size_t slot_bytes_ = 0;
+    size_t slot_count_ = 0;
+    std::vector<uint8_t*> free_;
+};
+
+#endif // NUMA_MEMORY_H
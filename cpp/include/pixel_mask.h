@@ -0,0 +1,107 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef PIXEL_MASK_H
+#define PIXEL_MASK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Per-chip hot/dead pixel mask applied on the decode path.
+ *
+ * Each chip has a 65536-bit bitmap indexed by the raw 16-bit pixel address
+ * of the pixel packet (bits 59-44), so a hit is tested before it is decoded
+ * or extended and masked hits never reach HitProcessor, the decode queues,
+ * or the block stages.
+ *
+ * Optional hot-pixel detection counts hits per pixel over a window of
+ * `window_hits` unmasked hits of a chip; at the end of each window pixels
+ * above mean + N sigma (sigma-clipped over the chip) are added to the mask.
+ *
+ * Not internally synchronized, like TimestampExtender: each chip's state
+ * must only be touched by the thread decoding that chip. Counters are read
+ * for reporting only while decoding is idle.
+ */
+class PixelMask {
+public:
+    static constexpr size_t PIXELS_PER_CHIP = 65536;
+
+    struct ChipReport {
+        uint64_t masked_hits = 0;      // Hits dropped by the mask
+        uint32_t masked_pixels = 0;    // Pixels currently masked
+        uint32_t auto_masked_pixels = 0;
+        uint32_t dead_pixels = 0;      // Pixels without hits in the last detection window
+        uint32_t windows = 0;          // Completed detection windows
+    };
+
+    PixelMask();
+
+    // Mask file: one pixel per line, "chip x y" ('#' starts a comment)
+    bool loadFromFile(const std::string& path, std::string& error);
+    bool saveToFile(const std::string& path, std::string& error) const;
+
+    void maskPixel(uint8_t chip, uint16_t x, uint16_t y);
+    bool isMasked(uint8_t chip, uint16_t x, uint16_t y) const;
+
+    void enableHotPixelDetection(double sigma, uint64_t window_hits);
+    bool hotPixelDetectionEnabled() const { return detect_; }
+
+    // Decode-path test on a raw pixel word; returns true if the hit is dropped
+    bool reject(uint8_t chip, uint64_t word) {
+        ChipState& state = chips_[chip];
+        uint16_t addr = static_cast<uint16_t>((word >> 44) & 0xFFFF);
+        if (testBit(state, addr)) {
+            state.report.masked_hits++;
+            return true;
+        }
+        if (detect_) {
+            observe(state, addr);
+        }
+        return false;
+    }
+
+    ChipReport chipReport(uint8_t chip) const { return chips_[chip].report; }
+    size_t maskedPixels() const;
+
+    static uint16_t xyToPixaddr(uint16_t x, uint16_t y) {
+        return static_cast<uint16_t>(((x >> 1) << 9) | ((y >> 2) << 3) | ((x & 1) << 2) | (y & 3));
+    }
+
+private:
+    struct alignas(64) ChipState {
+        std::vector<uint64_t> bits;      // Allocated on first masked pixel
+        std::vector<uint32_t> counts;    // Per-pixel hits in the current window
+        uint64_t window_count = 0;
+        ChipReport report;
+    };
+
+    static bool testBit(const ChipState& state, size_t addr) {
+        return !state.bits.empty() && ((state.bits[addr >> 6] >> (addr & 63)) & 1);
+    }
+    void setBit(ChipState& state, uint16_t addr);
+    void observe(ChipState& state, uint16_t addr) {
+        if (state.counts.empty()) {
+            state.counts.assign(PIXELS_PER_CHIP, 0);
+        }
+        state.counts[addr]++;
+        if (++state.window_count >= window_hits_) {
+            evaluateWindow(state);
+        }
+    }
+    void evaluateWindow(ChipState& state);
+
+    std::vector<ChipState> chips_;  // Indexed by 8-bit chip index
+    bool detect_;
+    double sigma_;
+    uint64_t window_hits_;
+};
+
+#endif // PIXEL_MASK_H
@@ -0,0 +1,95 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef QUEUE_TELEMETRY_H
+#define QUEUE_TELEMETRY_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Periodic sampler of queue depths and backlogs (gauges).
+ *
+ * A background thread reads every gauge at a fixed interval and stores the
+ * value in a per-gauge ring of the most recent samples. Summaries report
+ * min/mean/max over the ring window and the high-water mark over the whole
+ * run, so congestion shows up before a queue overflows and drops data.
+ * Gauges are read from the sampler thread and must be thread-safe.
+ */
+class QueueTelemetry {
+public:
+    using Gauge = std::function<uint64_t()>;
+
+    struct Summary {
+        std::string name;
+        uint64_t capacity = 0;         // 0 = unbounded / unknown
+        size_t samples = 0;            // Samples in the window
+        uint64_t latest = 0;
+        uint64_t min = 0;              // Window minimum
+        double mean = 0.0;             // Window mean
+        uint64_t max = 0;              // Window maximum
+        uint64_t high_water = 0;       // Maximum since start
+        double high_water_at_s = 0.0;  // Seconds since start() of the high-water sample
+    };
+
+    QueueTelemetry(std::chrono::milliseconds interval, size_t history);
+    ~QueueTelemetry();
+
+    QueueTelemetry(const QueueTelemetry&) = delete;
+    QueueTelemetry& operator=(const QueueTelemetry&) = delete;
+
+    // Register gauges before start()
+    void addGauge(const std::string& name, Gauge gauge, uint64_t capacity = 0);
+
+    void start();
+    void stop();  // Takes a last sample; idempotent
+
+    std::vector<Summary> summarize() const;
+    // Window samples of one gauge, oldest first
+    std::vector<uint64_t> history(size_t gauge_index) const;
+
+    std::chrono::milliseconds interval() const { return interval_; }
+
+private:
+    struct Series {
+        std::string name;
+        Gauge gauge;
+        uint64_t capacity = 0;
+        std::vector<uint64_t> ring;
+        size_t next = 0;
+        size_t filled = 0;
+        uint64_t high_water = 0;
+        double high_water_at_s = 0.0;
+    };
+
+    void sampleAll();
+    void samplerLoop();
+
+    std::chrono::milliseconds interval_;
+    size_t history_;
+    std::vector<Series> series_;
+    std::chrono::steady_clock::time_point start_time_;
+
+    mutable std::mutex mutex_;  // Guards the series rings
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+    bool stop_requested_ = false;
+    std::thread sampler_;
+};
+
+// Table of all gauges: latest, window min/mean/max, high-water and when it occurred
+void print_queue_telemetry(const QueueTelemetry& telemetry);
+
+#endif // QUEUE_TELEMETRY_H
@@ -0,0 +1,137 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef STATS_PUBLISHER_H
+#define STATS_PUBLISHER_H
+
+#include "hit_processor.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Serialize one statistics snapshot as a single-line JSON object (no trailing newline)
+std::string statistics_to_json(const Statistics& stats, uint64_t sequence, double elapsed_s);
+
+/**
+ * Fixed-layout statistics record in the shared-memory segment, for local
+ * readers that do not want to parse JSON (e.g. an EPICS IOC).
+ */
+struct StatsShmRecord {
+    uint64_t sequence;            // Publish count, 1 = first snapshot
+    uint64_t unix_time_ns;
+    double elapsed_s;
+    uint64_t total_hits;
+    uint64_t total_chunks;
+    uint64_t total_tdc1_events;
+    uint64_t total_tdc2_events;
+    uint64_t total_control_packets;
+    uint64_t total_decode_errors;
+    uint64_t total_fractional_errors;
+    uint64_t total_unknown_packets;
+    uint64_t total_reordered_packets;
+    double hit_rate_hz;
+    double tdc1_rate_hz;
+    double tdc2_rate_hz;
+    double cumulative_hit_rate_hz;
+    double cumulative_tdc1_rate_hz;
+    double cumulative_tdc2_rate_hz;
+    uint32_t chip_count;
+    uint32_t reserved;
+    double chip_hit_rates_hz[HitProcessor::MAX_CHIP_COUNT];
+    uint64_t chip_tdc1_counts[HitProcessor::MAX_CHIP_COUNT];
+};
+
+/**
+ * POSIX shared-memory segment (shm_open name) guarded by a seqlock: the
+ * sequence is odd while the publisher writes, so a reader retries when it
+ * sees an odd value or a change across its copy. Readers never block the
+ * publisher.
+ */
+struct StatsShmSegment {
+    static constexpr uint32_t MAGIC = 0x54505853;  // "TPXS"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t JSON_CAPACITY = 64 * 1024;
+
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint64_t> seqlock;
+    StatsShmRecord record;
+    uint32_t json_length;
+    char json[JSON_CAPACITY];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "seqlock needs a lock-free 64-bit atomic");
+
+// Consistent copy of the segment; false if no snapshot is published yet or
+// the writer kept it busy for all attempts
+bool stats_shm_read(const StatsShmSegment& segment, StatsShmRecord& record, std::string& json,
+                    int max_attempts = 1000);
+
+/**
+ * Periodically publishes statistics snapshots to any of: a JSON-lines file,
+ * a UNIX datagram socket (one JSON object per datagram, dropped when nobody
+ * listens) and a shared-memory segment. Snapshots come from a caller-supplied
+ * function on the publisher's own thread, so the data path is never waited on.
+ */
+class StatsPublisher {
+public:
+    struct Config {
+        std::string jsonl_path;         // Append JSON lines ("" = off)
+        std::string unix_socket_path;   // sendto() datagrams ("" = off)
+        std::string shm_name;           // shm_open name, e.g. "/tpx3_stats" ("" = off)
+        std::chrono::milliseconds interval{1000};
+
+        bool enabled() const { return !jsonl_path.empty() || !unix_socket_path.empty() || !shm_name.empty(); }
+    };
+    using SnapshotFn = std::function<Statistics()>;
+
+    StatsPublisher(const Config& config, SnapshotFn snapshot);
+    ~StatsPublisher();
+
+    StatsPublisher(const StatsPublisher&) = delete;
+    StatsPublisher& operator=(const StatsPublisher&) = delete;
+
+    // Open the sinks; returns false with a message when one cannot be opened
+    bool open(std::string& error);
+    void start();
+    void stop();  // Publishes a last snapshot; idempotent
+
+    void publish(const Statistics& stats);
+
+    uint64_t published() const { return sequence_; }
+    uint64_t socketSendFailures() const { return socket_send_failures_; }
+
+private:
+    void publisherLoop();
+
+    Config config_;
+    SnapshotFn snapshot_;
+    std::chrono::steady_clock::time_point start_time_;
+    uint64_t sequence_ = 0;
+    uint64_t socket_send_failures_ = 0;
+
+    std::ofstream jsonl_;
+    int socket_fd_ = -1;
+    StatsShmSegment* shm_ = nullptr;
+
+    std::mutex publish_mutex_;  // publish() from the thread and from stop()
+    std::mutex stop_mutex_;
+    std::condition_variable stop_cv_;
+    bool stop_requested_ = false;
+    std::thread thread_;
+};
+
+#endif // STATS_PUBLISHER_H
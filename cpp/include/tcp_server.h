@@ -10,6 +10,7 @@
 #define TCP_SERVER_H
 
 #include <cstddef>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 
@@ -18,6 +19,9 @@ public:
     using DataCallback = std::function<void(const uint8_t* data, size_t size)>;
     using ConnectionCallback = std::function<void(bool connected)>;
     
+    // recv() size; also the largest block handed to the data callback
+    static constexpr size_t RECV_BUFFER_SIZE = 1024 * 1024;
+    
     TCPServer(const char* host, uint16_t port);
     ~TCPServer();
     
@@ -41,19 +45,64 @@ public:
         uint64_t bytes_received = 0;
         uint64_t bytes_dropped_incomplete = 0;  // Bytes dropped due to incomplete words
         uint64_t recv_errors = 0;
+        int rcvbuf_requested = 0;               // SO_RCVBUF asked for
+        int rcvbuf_effective = 0;               // SO_RCVBUF granted (as reported by the kernel, i.e. doubled)
+    };
+    
+    // Per-connection kernel view of the socket (getsockopt TCP_INFO + SIOCINQ)
+    struct SocketInfo {
+        bool valid = false;                     // False when not connected / unavailable
+        uint32_t rcv_space = 0;                 // Receiver's estimate of the sender window (bytes)
+        uint32_t rcv_ssthresh = 0;              // Current receive window clamp (bytes)
+        uint32_t rtt_us = 0;
+        uint32_t rttvar_us = 0;
+        uint32_t rcv_rtt_us = 0;                // Receiver-side RTT estimate
+        uint32_t total_retrans = 0;             // Segments retransmitted (both directions)
+        uint32_t lost = 0;
+        size_t backlog_bytes = 0;               // Unread bytes in the receive queue
+    };
+    
+    // System-wide TcpExt receive-side drop counters from /proc/net/netstat
+    struct KernelNetStats {
+        bool available = false;
+        uint64_t prune_called = 0;              // Receive queue over budget, pruning attempted
+        uint64_t rcv_pruned = 0;                // Packets dropped from the receive queue
+        uint64_t ofo_pruned = 0;                // Out-of-order queue dropped
+        uint64_t rcv_collapsed = 0;             // Packets collapsed to reclaim memory
+        uint64_t rcvq_drop = 0;                 // Dropped: receive queue full
+        uint64_t backlog_drop = 0;              // Dropped: socket backlog full
+        uint64_t to_zero_window_adv = 0;        // Zero window advertised
+        uint64_t want_zero_window_adv = 0;      // Window would have been zero
+        
+        KernelNetStats since(const KernelNetStats& baseline) const;
     };
     
     const ConnectionStats& getConnectionStats() const { return stats_; }
+    
+    // Bytes waiting in the kernel receive queue (SIOCINQ); 0 when not connected.
+    // Safe to call from another thread.
+    size_t receiveBacklog() const;
+    
+    // Sample TCP_INFO of the current connection; safe to call from another thread
+    SocketInfo sampleSocketInfo() const;
+    // Last sample taken before the most recent disconnect (read after run() returns)
+    const SocketInfo& lastSocketInfo() const { return last_socket_info_; }
+    
+    static bool readKernelNetStats(KernelNetStats& out);
+    // TcpExt counter changes since run() was first called
+    KernelNetStats kernelNetStatsSinceStart() const;
     void resetConnectionStats() { stats_ = ConnectionStats(); }
     
 private:
     const char* host_;
     uint16_t port_;
-    int socket_;
+    std::atomic<int> socket_;  // Read by receiveBacklog() from other threads
     bool connected_;
     bool should_stop_;
     ConnectionCallback connection_cb_;
     ConnectionStats stats_;
+    SocketInfo last_socket_info_;
+    KernelNetStats net_stats_baseline_;
     
     // Buffer for incomplete words (bytes not in multiples of 8)
     uint8_t incomplete_buffer_[8];
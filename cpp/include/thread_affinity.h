@@ -0,0 +1,58 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef THREAD_AFFINITY_H
+#define THREAD_AFFINITY_H
+
+#include <pthread.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Parse a Linux CPU list such as "0-3,8,10-11"; false on malformed input
+bool parse_cpu_list(const std::string& text, std::vector<int>& cpus);
+std::string format_cpu_list(const std::vector<int>& cpus);
+
+// Restrict a thread to the given CPUs (empty = leave unchanged)
+bool pin_thread(pthread_t thread, const std::vector<int>& cpus, std::string& error);
+bool pin_current_thread(const std::vector<int>& cpus, std::string& error);
+std::vector<int> current_thread_cpus();
+
+// SCHED_FIFO with the given priority (1-99) for the calling thread; needs CAP_SYS_NICE
+bool set_current_thread_fifo(int priority, std::string& error);
+
+// NUMA topology from sysfs; -1 / empty when unknown (e.g. loopback or single node)
+int numa_node_count();
+std::vector<int> numa_node_cpus(int node);
+int numa_node_of_cpu(int cpu);
+// Interface the kernel would use to reach host (IPv4), e.g. "eth0"; empty if unknown
+std::string route_interface(const std::string& host, uint16_t port);
+int interface_numa_node(const std::string& interface);
+
+/**
+ * CPU placement of the pipeline threads: network (recv), processing
+ * (chunk framing) and decoder workers (worker i runs on workers[i % size]).
+ * Empty lists leave a role unpinned.
+ */
+struct ThreadPlacement {
+    std::vector<int> network;
+    std::vector<int> processing;
+    std::vector<int> workers;
+    int network_fifo_priority = 0;  // 0 = normal scheduling
+    int numa_node = -1;             // Node chosen by automatic placement
+
+    bool any() const { return !network.empty() || !processing.empty() || !workers.empty(); }
+
+    // Fill unset roles from the CPUs of the NIC's NUMA node (all allowed
+    // CPUs when the node is unknown): network (if used) and processing get
+    // one CPU each, the decoder workers share the rest
+    void autoPlace(int node, size_t worker_count, bool network_thread);
+};
+
+#endif // THREAD_AFFINITY_H
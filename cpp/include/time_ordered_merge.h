@@ -0,0 +1,113 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef TIME_ORDERED_MERGE_H
+#define TIME_ORDERED_MERGE_H
+
+#include "hit_block.h"
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * K-way merge of per-chip time-sorted hit runs into one globally
+ * time-ordered stream.
+ *
+ * Producers push runs (one per chip chunk, sorted by ToA) together with the
+ * chip's progress, i.e. the latest timestamp the chip's data has reached
+ * (the chunk's max_timestamp_ns when extra packets are present). Hits are
+ * released through a tournament tree once they fall below the watermark
+ *
+ *   max(min over chips of progress, newest progress - max_delay) - lateness
+ *
+ * so output is complete and ordered as long as no chip delivers a hit more
+ * than `lateness` behind its own progress. Expected chips that have not
+ * delivered anything yet count as progress 0. Latency is bounded by max_delay
+ * (a stalled chip stops holding back the others) and memory by
+ * max_buffered_hits (oldest hits are released early when exceeded).
+ * Hits that arrive behind already released output are forwarded anyway
+ * and counted as late.
+ *
+ * Runs live in reusable slots at the leaves of the tree: a pushed run takes a
+ * free slot and only that leaf's path is replayed, as is the winner's path
+ * after each emitted hit. The tree is rebuilt only when the slot count grows.
+ *
+ * Thread-safe; the batch callback is invoked serially under the merger lock.
+ */
+class TimeOrderedMerger {
+public:
+    using BatchCallback = std::function<void(const HitBlock& batch)>;
+    
+    struct Config {
+        uint64_t lateness_ticks = 640000;       // 1 ms in 1.5625ns units
+        uint64_t max_delay_ticks = 320000000;   // 0.5 s in 1.5625ns units
+        size_t max_buffered_hits = 4000000;
+        size_t batch_size = 4096;
+        size_t expected_chips = 0;  // Chips 0..N-1 hold back output until seen (bounded by max_delay)
+    };
+    
+    struct Statistics {
+        uint64_t runs_received = 0;
+        uint64_t hits_received = 0;
+        uint64_t hits_emitted = 0;
+        uint64_t batches_emitted = 0;
+        uint64_t late_hits = 0;             // Emitted behind previously released output
+        uint64_t forced_hits = 0;           // Released early to respect max_buffered_hits
+        uint64_t max_buffered_hits = 0;     // High-water mark of buffered hits
+        uint64_t max_pending_runs = 0;
+    };
+    
+    explicit TimeOrderedMerger(const Config& config, BatchCallback callback = nullptr);
+    
+    // Add a run of hits from one chip, sorted by ToA
+    void pushRun(uint8_t chip_index, HitBlock&& run, uint64_t chip_progress_ticks);
+    
+    // Release everything still buffered (end of stream)
+    void flush();
+    
+    Statistics getStatistics() const;
+    size_t bufferedHits() const;
+    
+private:
+    struct Run {
+        HitBlock hits;
+        size_t cursor = 0;
+        uint64_t sequence = 0;  // Push order, breaks ToA ties
+    };
+    
+    Config config_;
+    BatchCallback callback_;
+    std::vector<Run> runs_;            // Slots; exhausted slots are listed in free_slots_
+    std::vector<uint32_t> free_slots_;
+    size_t active_runs_;
+    uint64_t next_sequence_;
+    std::vector<uint64_t> chip_progress_;
+    std::vector<bool> chip_seen_;
+    uint64_t newest_progress_;
+    uint64_t last_emitted_toa_;
+    size_t buffered_hits_;
+    HitBlock batch_;
+    std::vector<uint32_t> tree_;   // Leaves at [k, 2k) for k slots; node n holds the winner of 2n and 2n+1
+    Statistics stats_;
+    mutable std::mutex mutex_;
+    
+    uint64_t watermark() const;
+    void drainLocked(uint64_t limit, size_t keep_buffered);
+    
+    // Tournament tree over the slots of runs_
+    uint64_t runKey(uint32_t run) const;
+    bool runBefore(uint32_t a, uint32_t b) const;
+    uint32_t takeSlot();
+    void buildTree();
+    void replay(uint32_t run);
+    
+    void emitBatchLocked();
+};
+
+#endif // TIME_ORDERED_MERGE_H
@@ -0,0 +1,57 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef TIME_WALK_H
+#define TIME_WALK_H
+
+#include "hit_block.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * ToT-dependent time-walk correction of pixel ToA.
+ *
+ * Small signals cross the discriminator threshold late. The delay is
+ * modelled per chip as
+ *     delay_ns(ToT) = a / (ToT_ns - b)^c
+ * and tabulated once per chip over the 1024 possible ToT counts (25 ns
+ * each), so correcting a hit is one table load and a subtraction. ToT at or
+ * below b is evaluated at the first ToT count above b.
+ *
+ * Parameter file format (text, one chip per line, '#' starts a comment):
+ *     chip a b c
+ */
+class TimeWalkCorrection {
+public:
+    static constexpr size_t TOT_COUNTS = 1024;      // 10-bit ToT
+    static constexpr uint16_t TOT_NS_PER_COUNT = 25;
+    static constexpr double TICKS_PER_NS = 0.64;    // ToA units of 1.5625 ns
+
+    TimeWalkCorrection();
+
+    // Returns false and sets `error` on I/O or parse failure
+    bool loadFromFile(const std::string& path, std::string& error);
+
+    // Tabulate the delay curve for one chip (returns false for a < 0 or c <= 0)
+    bool setChip(uint8_t chip, double a, double b, double c);
+
+    // Subtract the tabulated delay from every hit's ToA (clamped at 0)
+    void apply(HitBlock& block) const;
+
+    size_t correctedChips() const;
+
+    // Tabulated delay in ToA ticks (0 for chips without parameters)
+    uint32_t delayTicks(uint8_t chip, uint16_t tot_ns) const;
+
+private:
+    std::vector<std::vector<uint32_t>> tables_;  // Indexed by 8-bit chip index, then ToT count
+};
+
+#endif // TIME_WALK_H
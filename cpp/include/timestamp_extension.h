@@ -9,10 +9,13 @@
 #ifndef TIMESTAMP_EXTENSION_H
 #define TIMESTAMP_EXTENSION_H
 
+#include <cstddef>
 #include <cstdint>
+#include <vector>
 
 // Forward declaration
 struct PixelHit;
+struct GlobalTime;
 
 // Extend timestamp using minimum timestamp
 // Based on the Rust implementation from the manual
@@ -32,5 +35,74 @@ inline uint64_t extend_timestamp(uint64_t timestamp, uint64_t minimum_timestamp,
 // Implementation in .cpp to avoid circular dependency
 void extend_pixel_hit_timestamp(PixelHit& hit, uint64_t minimum_timestamp, uint64_t n_bits);
 
-#endif // TIMESTAMP_EXTENSION_H
+/**
+ * Per-chip extension of pixel ToA and TDC timestamps to monotonic 64-bit
+ * values in 1.5625ns units.
+ *
+ * Pixel ToA wraps after 34 bits (SPIDR time, ~26.8 s) and TDC after 36 bits
+ * (~107 s). Each chip keeps a reference time anchored by Global Time packets
+ * (0x44/0x45, 48-bit in 25ns units) and advanced by every extended timestamp,
+ * so runs without global time packets are still tracked across wraps as long
+ * as consecutive events of a chip are less than half a wrap period apart.
+ *
+ * Extension is branch-free: a timestamp is placed in the window
+ * [reference - half_period, reference + half_period).
+ *
+ * Not internally synchronized. Each chip's state must only be touched by one
+ * thread at a time (in DecodeDispatcher, by the worker currently running that
+ * chip's strand); state is cache-line padded so different chips can be used
+ * from different threads.
+ */
+class TimestampExtender {
+public:
+    static constexpr uint64_t PIXEL_TOA_BITS = 34;   // ((SPIDR << 14) + ToA) << 4
+    static constexpr uint64_t TDC_BITS = 36;         // (coarse << 1) | fine
+    static constexpr uint64_t GLOBAL_LOW_BITS = 36;  // 32-bit 25ns counter in 1.5625ns units
+    
+    TimestampExtender();
+    
+    // Decode result of a 0x44/0x45 packet for this chip
+    void updateGlobalTime(uint8_t chip_index, const GlobalTime& gt);
+    
+    uint64_t extendPixel(uint8_t chip_index, uint64_t toa_ticks) {
+        return extend(states_[chip_index], toa_ticks, PIXEL_TOA_BITS);
+    }
+    
+    uint64_t extendTdc(uint8_t chip_index, uint64_t tdc_ticks) {
+        return extend(states_[chip_index], tdc_ticks, TDC_BITS);
+    }
+    
+    // Place a wrapped timestamp within half a wrap period of `reference`
+    static uint64_t placeNear(uint64_t ticks, uint64_t reference, uint64_t n_bits) {
+        return extend_timestamp(ticks, windowStart(reference, n_bits), n_bits);
+    }
+    
+    uint64_t referenceTicks(uint8_t chip_index) const { return states_[chip_index].reference; }
+    uint64_t globalTimePackets() const;
+    
+    void reset();
+    
+private:
+    struct alignas(64) ChipState {
+        uint64_t reference = 0;        // Latest known full time, 1.5625ns units
+        uint64_t global_low = 0;       // Last 0x44 value (25ns units)
+        uint64_t global_packets = 0;
+        bool has_global_low = false;
+    };
+    
+    static uint64_t windowStart(uint64_t reference, uint64_t n_bits) {
+        uint64_t half = 1ULL << (n_bits - 1);
+        return reference - (reference < half ? reference : half);
+    }
+    
+    static uint64_t extend(ChipState& state, uint64_t ticks, uint64_t n_bits) {
+        uint64_t extended = extend_timestamp(ticks, windowStart(state.reference, n_bits), n_bits);
+        state.reference = extended > state.reference ? extended : state.reference;
+        return extended;
+    }
+    
+    // Indexed directly by the 8-bit chip index, so lookups need no bounds check
+    std::vector<ChipState> states_;
+};
 
+#endif // TIMESTAMP_EXTENSION_H
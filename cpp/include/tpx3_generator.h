@@ -0,0 +1,129 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#ifndef TPX3_GENERATOR_H
+#define TPX3_GENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Word encoders (inverse of the decoders in tpx3_decoder.h). Times are in
+// 1.5625ns ticks unless noted.
+uint64_t encode_pixel_standard(uint16_t x, uint16_t y, uint64_t toa_ticks, uint16_t tot_counts);
+uint64_t encode_pixel_count_fb(uint16_t x, uint16_t y, uint64_t toa_ticks, uint16_t tot_counts);
+uint64_t encode_tdc(uint8_t type, uint16_t trigger_count, uint64_t timestamp_ticks, uint8_t fract);
+uint64_t encode_global_time_low(uint64_t time_25ns);
+uint64_t encode_global_time_high(uint64_t time_25ns);
+uint64_t encode_spidr_packet_id(uint64_t packet_count);
+uint64_t encode_extra_timestamp(uint64_t timestamp_ticks);
+uint64_t encode_chunk_header(uint8_t chip_index, size_t data_words);
+
+/**
+ * Deterministic synthetic TPX3 stream generator.
+ *
+ * Produces the chunked raw stream SERVAL sends: per chip and chunk period a
+ * chunk header followed by pixel words (in double-column readout order, not
+ * time order), SPIDR packet IDs, global time pairs, TDC1 words on one chip
+ * and the three extra timestamps that close a chunk. Hits come in clusters
+ * (one particle event = several neighbouring pixels sharing a ToA, with the
+ * largest ToT at the centre). Optional faults exercise the parser's error
+ * paths. The same configuration and seed always give the same bytes.
+ */
+class Tpx3Generator {
+public:
+    struct Config {
+        uint64_t seed = 1;
+        size_t chip_count = 4;
+        double duration_s = 1.0;           // Data time to generate
+        double hit_rate_hz = 1.0e6;        // Pixel hits per second, all chips
+        double hot_chip_share = 0.0;       // Fraction of the hits on chip 0 (0 = even split)
+        double chunk_period_s = 1.0e-3;    // Data time covered by one chunk per chip
+        double cluster_size_mean = 4.0;    // Pixels per event (1 = isolated hits)
+        double beam_sigma_px = 0.0;        // Gaussian beam spot at the chip centre (0 = uniform)
+        double tdc_frequency_hz = 60.0;    // TDC1 rising edges on tdc_chip (0 = none)
+        uint8_t tdc_chip = 0;
+        double global_time_interval_s = 0.1;  // 0x44/0x45 pairs per chip (0 = none)
+        size_t packet_id_interval = 64;    // Words between SPIDR packet IDs (0 = none)
+        bool count_fb = false;             // Emit 0xa pixel words instead of 0xb
+        bool extra_timestamps = true;      // Close chunks with the three 0x51 words
+        uint64_t start_ticks = 0;          // Data time of the first chunk
+
+        // Fault injection (probabilities per opportunity)
+        double fault_packet_id_swap = 0.0;     // Swap a SPIDR packet ID with its successor
+        double fault_truncated_chunk = 0.0;    // Cut a chunk short of its announced size
+        double fault_bad_tdc_fraction = 0.0;   // TDC fine part outside 1-12
+    };
+
+    struct Statistics {
+        uint64_t chunks = 0;
+        uint64_t words = 0;
+        uint64_t hits = 0;
+        uint64_t events = 0;
+        uint64_t tdc_events = 0;
+        uint64_t global_time_pairs = 0;
+        uint64_t packet_ids = 0;
+        uint64_t faults_packet_id_swap = 0;
+        uint64_t faults_truncated_chunk = 0;
+        uint64_t faults_bad_tdc_fraction = 0;
+    };
+
+    // Largest chunk: the header's 16-bit size field counts bytes
+    static constexpr size_t MAX_CHUNK_WORDS = 0xFFFF / 8;
+
+    explicit Tpx3Generator(const Config& config);
+
+    // Append the next chunk (header included) to `out`; false when done
+    bool nextChunk(std::vector<uint64_t>& out);
+
+    // Data time reached so far, in seconds
+    double dataTime() const;
+    bool done() const { return period_ >= total_periods_; }
+    const Statistics& getStatistics() const { return stats_; }
+    const Config& config() const { return config_; }
+
+private:
+    struct Hit {
+        uint64_t toa;
+        uint16_t x;
+        uint16_t y;
+        uint16_t tot;
+    };
+
+    // Data word with the ToA it carries (NO_TIME for non-pixel words)
+    struct Word {
+        uint64_t word;
+        uint64_t toa;
+    };
+    static constexpr uint64_t NO_TIME = UINT64_MAX;
+
+    void generatePeriod();
+    void generateChip(uint8_t chip, uint64_t begin, uint64_t end);
+    void addEvent(std::vector<Hit>& hits, uint64_t begin, uint64_t end);
+    void insertPacketIds(uint8_t chip, std::vector<Word>& words);
+    void emitChunks(uint8_t chip, const std::vector<Word>& words, uint64_t generated);
+
+    Config config_;
+    Statistics stats_;
+    std::mt19937_64 rng_;
+    uint64_t period_;
+    uint64_t total_periods_;
+    uint64_t period_ticks_;
+    uint64_t next_tdc_ticks_;
+    uint64_t global_interval_ticks_;
+    uint64_t next_global_ticks_;
+    uint16_t trigger_count_;
+    std::vector<uint64_t> packet_counts_;          // SPIDR packet ID per chip
+    std::vector<Hit> hits_;
+    std::vector<Word> words_;
+    std::vector<std::vector<uint64_t>> pending_;  // Chunks of the current period, in output order
+    size_t pending_index_;
+};
+
+#endif // TPX3_GENERATOR_H
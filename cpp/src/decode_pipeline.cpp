@@ -0,0 +1,371 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "decode_pipeline.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+static std::string format_type_label(const std::string& prefix, uint8_t type) {
+    std::ostringstream oss;
+    oss << prefix << " (0x" << std::hex << std::uppercase << std::setfill('0')
+        << std::setw(2) << static_cast<int>(type) << ")";
+    return oss.str();
+}
+
+// Helper function to process a single packet (used by reorder buffer callback)
+void process_packet(uint64_t word, uint8_t chip_index, HitProcessor& processor, const ChunkMetadata& chunk_meta, bool enable_accounting,
+                    const DecodeContext& ctx) {
+    // Check full-byte types first (0x50, 0x71, etc. that can't be distinguished by 4-bit)
+    uint8_t full_type = (word >> 56) & 0xFF;
+    
+    if (full_type == SPIDR_PACKET_ID) {
+        if (enable_accounting) {
+            processor.addPacketBytes("SPIDR packet ID (0x50)", 8);
+        }
+        // SPIDR packet ID (0x50)
+        uint64_t packet_count;
+        if (decode_spidr_packet_id(word, packet_count)) {
+            // Packet count tracking
+        }
+        return;
+    }
+    
+    if (full_type == TPX3_CONTROL) {
+        if (enable_accounting) {
+            processor.addPacketBytes("TPX3 control (0x71)", 8);
+        }
+        // TPX3 control (0x71)
+        Tpx3ControlCmd cmd;
+        if (decode_tpx3_control(word, cmd)) {
+            // Control command decoded
+        }
+        return;
+    }
+    
+    if (full_type == EXTRA_TIMESTAMP || full_type == EXTRA_TIMESTAMP_MPX3) {
+        if (enable_accounting) {
+            processor.addPacketBytes(format_type_label("Extra timestamp", full_type), 8);
+        }
+        // Extra timestamp packets - handled separately in main processing loop
+        return;
+    }
+    
+    if (full_type == GLOBAL_TIME_LOW || full_type == GLOBAL_TIME_HIGH) {
+        if (enable_accounting) {
+            processor.addPacketBytes(format_type_label("Global time", full_type), 8);
+        }
+        // Global time anchors the chip's timestamp extension
+        if (ctx.extender) {
+            ctx.extender->updateGlobalTime(chip_index, decode_global_time(word));
+        }
+        return;
+    }
+    
+    // For other packets, use 4-bit type
+    uint8_t packet_type = (word >> 60) & 0xF;
+    if (enable_accounting) {
+        processor.incrementPacketType(packet_type);
+    }
+    
+    switch (packet_type) {
+        case PIXEL_COUNT_FB:
+        case PIXEL_STANDARD: {
+            if (enable_accounting) {
+                if (packet_type == PIXEL_COUNT_FB) {
+                    processor.addPacketBytes("Pixel count_fb (0x0a)", 8);
+                } else {
+                    processor.addPacketBytes("Pixel standard (0x0b)", 8);
+                }
+            }
+            if (ctx.mask && ctx.mask->reject(chip_index, word)) {
+                return;
+            }
+            try {
+                PixelHit hit = decode_pixel_data(word, chip_index);
+                
+                // Apply timestamp extension if we have chunk metadata
+                if (chunk_meta.has_extra_packets) {
+                    // Extract 30-bit timestamp
+                    uint64_t truncated_toa = hit.toa_ns & 0x3FFFFFFF;
+                    hit.toa_ns = extend_timestamp(truncated_toa, chunk_meta.min_timestamp_ns, 30);
+                } else if (ctx.extender) {
+                    // Otherwise extend past the 34-bit SPIDR wrap using per-chip global time
+                    hit.toa_ns = ctx.extender->extendPixel(chip_index, hit.toa_ns);
+                }
+                
+                processor.addHit(hit);
+                if (ctx.collector) {
+                    ctx.collector->add(hit);
+                }
+            } catch (const std::exception& e) {
+                processor.incrementDecodeError();
+                // Only print first few errors to avoid flooding output
+                static int pixel_error_count = 0;
+                if (pixel_error_count++ < 5) {
+                    std::cerr << "Error decoding pixel data: " << e.what() << std::endl;
+                }
+            }
+            break;
+        }
+        
+        case TDC_DATA: {
+            if (enable_accounting) {
+                processor.addPacketBytes("TDC data (0x06)", 8);
+            }
+            try {
+                TDCEvent tdc = decode_tdc_data(word);
+                if (ctx.extender) {
+                    tdc.timestamp_ns = ctx.extender->extendTdc(chip_index, tdc.timestamp_ns);
+                }
+                if (ctx.tdc1_history && tdc.type == TDC1_RISE) {
+                    ctx.tdc1_history->record(chip_index, tdc.timestamp_ns);
+                }
+                processor.addTdcEvent(tdc, chip_index);
+            } catch (const std::exception& e) {
+                processor.incrementDecodeError();
+                // Check if this is a fractional error
+                std::string error_msg = e.what();
+                if (error_msg.find("fractional") != std::string::npos) {
+                    processor.incrementFractionalError();
+                }
+                // Only print first few errors to avoid flooding output
+                static int tdc_error_count = 0;
+                if (tdc_error_count++ < 5) {
+                    std::cerr << "Error decoding TDC data: " << error_msg << std::endl;
+                }
+            }
+            break;
+        }
+        
+        case SPIDR_CONTROL: {
+            if (enable_accounting) {
+                processor.addPacketBytes("SPIDR control (0x05)", 8);
+            }
+            SpidrControl ctrl;
+            if (decode_spidr_control(word, ctrl)) {
+                processor.incrementChunkCount();
+            }
+            break;
+        }
+        
+        default: {
+            if (enable_accounting) {
+                std::ostringstream label;
+                label << "Unknown packet type (0x" << std::hex << std::uppercase
+                      << static_cast<int>(packet_type) << ")";
+                processor.addPacketBytes(label.str(), 8);
+                processor.incrementUnknownPacket();
+            }
+            break;
+        }
+    }
+}
+
+// Flush batch buffer to dispatcher or process directly
+static void flushBatch(StreamState& state, HitProcessor& processor, DecodeDispatcher* dispatcher, bool enable_accounting) {
+    if (state.batch_buffer.empty()) return;
+    
+    if (dispatcher) {
+        dispatcher->submitBatch(state.batch_buffer, state.chip_index, state.chunk_meta);
+    } else {
+        for (uint64_t word : state.batch_buffer) {
+            process_packet(word, state.chip_index, processor, state.chunk_meta, enable_accounting,
+                           state.decode);
+        }
+    }
+    state.batch_buffer.clear();
+}
+
+// Enter the mode the policy asks for. Only at a chunk boundary: the batch is
+// flushed and the previous chunk's end marker is submitted
+static void apply_decode_mode(StreamState& state, DecodeDispatcher& dispatcher) {
+    DecodeMode target = state.dispatch_policy->desired();
+    if (target == state.decode_mode) {
+        return;
+    }
+    if (target == DecodeMode::Inline) {
+        // Workers must be done with the per-chip state before this thread uses it
+        dispatcher.waitUntilDrained();
+    } else {
+        state.decode.collector = nullptr;
+    }
+    state.decode_mode = target;
+    state.dispatch_policy->applied(target);
+}
+
+// Process raw data buffer
+void process_raw_data(const uint8_t* buffer, size_t bytes, HitProcessor& processor, StreamState& state,
+                      DecodeDispatcher* dispatcher, PacketReorderBuffer* reorder_buffer,
+                      bool enable_accounting) {
+    const uint64_t* data_words = reinterpret_cast<const uint64_t*>(buffer);
+    size_t num_words = bytes / 8;
+    // Full dispatcher, kept for mode switches; `dispatcher` is the one in effect
+    DecodeDispatcher* pool = dispatcher;
+    if (pool && state.decode_mode == DecodeMode::Inline) {
+        dispatcher = nullptr;
+    }
+    
+    for (size_t i = 0; i < num_words; ++i) {
+        uint64_t word = data_words[i];
+        
+        // Fast inline chunk header check (avoid struct creation on hot path)
+        // TPX3_MAGIC is 0x33585054 ('TPX3' in little-endian)
+        if ((word & 0xFFFFFFFFULL) == TPX3_MAGIC) {
+            // Flush any pending batch before starting new chunk
+            flushBatch(state, processor, dispatcher, enable_accounting);
+            
+            // Found chunk header - inline field access to avoid struct creation
+            if (enable_accounting) {
+                processor.addPacketBytes("Chunk header", 8);
+            }
+            state.saw_first_chunk_header = true;
+            // Note: chunk size includes the header word itself
+            // So we set chunk_words_remaining to chunkSize/8, which includes header
+            // We then continue to skip the header, so we process (chunkSize/8 - 1) data words
+            state.in_chunk = true;
+            // Inline field access: chunkSize() = (word >> 48) & 0xFFFF, chipIndex() = (word >> 32) & 0xFF
+            state.chunk_words_remaining = ((word >> 48) & 0xFFFF) / 8;
+            state.chip_index = (word >> 32) & 0xFF;
+            if (pool && state.dispatch_policy) {
+                apply_decode_mode(state, *pool);
+                dispatcher = state.decode_mode == DecodeMode::Parallel ? pool : nullptr;
+                if (!dispatcher) {
+                    state.decode.collector = pool->chipCollector(state.chip_index);
+                }
+            }
+            
+            // Use local counter to avoid mutex lock on getStatistics()
+            // This eliminates the expensive getStatistics() call that acquires a mutex
+            state.local_chunk_count++;
+            state.current_chunk_id = state.local_chunk_count;
+            state.pending_chunk_updates++;
+            
+            // Batch update chunk count to reduce mutex contention (update every 100 chunks)
+            // In performance mode, batch updates significantly reduce lock contention
+            // Instead of 100 mutex locks, we use 1 mutex lock per 100 chunks
+            constexpr uint64_t CHUNK_UPDATE_BATCH = 100;
+            if (state.pending_chunk_updates >= CHUNK_UPDATE_BATCH) {
+                // Batch update: increment by pending count in a single mutex lock
+                processor.incrementChunkCountBatch(state.pending_chunk_updates);
+                state.pending_chunk_updates = 0;
+            }
+            
+            // If we have a reorder buffer, reset it for new chunk
+            if (reorder_buffer) {
+                reorder_buffer->resetForNewChunk(state.current_chunk_id);
+            }
+            
+            // Reset chunk metadata
+            state.chunk_meta = {};
+            state.extra_timestamps.clear();
+            
+            continue;
+        }
+        
+        if (!state.in_chunk || state.chunk_words_remaining == 0) {
+            if (!state.saw_first_chunk_header && !state.mid_stream_flagged) {
+                processor.markMidStreamStart();
+                state.mid_stream_flagged = true;
+            }
+            if (enable_accounting) {
+                processor.addPacketBytes("Unassigned (outside chunk)", 8);
+            }
+            continue;
+        }
+        
+        state.chunk_words_remaining--;
+        
+        // Fast path: Check packet type byte first (most words are pixel data)
+        uint8_t full_type = (word >> 56) & 0xFF;
+        
+        // Check if we're near the end of chunk (last 3 words are extra timestamps)
+        bool is_near_end = (state.chunk_words_remaining <= 3);
+        
+        if (is_near_end && (full_type == EXTRA_TIMESTAMP || full_type == EXTRA_TIMESTAMP_MPX3)) {
+            // Flush batch before processing extra timestamp (chunk_meta may change)
+            flushBatch(state, processor, dispatcher, enable_accounting);
+            
+            // Extra timestamp packet (rare - only at end of chunk)
+            uint8_t extra_type = static_cast<uint8_t>(full_type);
+            if (enable_accounting) {
+                processor.addPacketBytes(format_type_label("Extra timestamp", extra_type), 8);
+            }
+            ExtraTimestamp extra_ts = decode_extra_timestamp(word);
+            state.extra_timestamps.push_back(extra_ts);
+            
+            // When we have all 3 extra packets, process them
+            if (state.extra_timestamps.size() == 3) {
+                state.chunk_meta.has_extra_packets = true;
+                state.chunk_meta.packet_gen_time_ns = state.extra_timestamps[0].timestamp_ns;
+                state.chunk_meta.min_timestamp_ns = state.extra_timestamps[1].timestamp_ns;
+                state.chunk_meta.max_timestamp_ns = state.extra_timestamps[2].timestamp_ns;
+                
+                processor.processChunkMetadata(state.chunk_meta);
+            }
+        } else if (full_type == SPIDR_PACKET_ID && reorder_buffer) {
+            // SPIDR packet ID packet (needs reordering). Released words join the
+            // batch after the words before them, so a flush delivers one segment
+            // per chip instead of one per reordered word
+            uint64_t packet_count = 0;
+            auto append = [&processor, &state, dispatcher, enable_accounting](uint64_t w) {
+                state.batch_buffer.push_back(w);
+                if (state.batch_buffer.size() >= state.batch_size) {
+                    flushBatch(state, processor, dispatcher, enable_accounting);
+                }
+            };
+            if (decode_spidr_packet_id(word, packet_count)) {
+                reorder_buffer->processPacket(word, packet_count, state.current_chunk_id,
+                    [&append](uint64_t w, uint64_t /*id*/, uint64_t /*chunk*/) { append(w); });
+            } else {
+                // Decode failed, pass through unordered
+                append(word);
+            }
+        } else {
+            // Fast path: Regular packet (most common case - pixel data, TDC, control, etc.)
+            // Collect in batch buffer to reduce mutex contention
+            state.batch_buffer.push_back(word);
+            
+            // Flush batch when it reaches the batch size
+            if (state.batch_buffer.size() >= state.batch_size) {
+                flushBatch(state, processor, dispatcher, enable_accounting);
+            }
+        }
+        
+        if (state.chunk_words_remaining == 0) {
+            // Flush batch at chunk boundary
+            flushBatch(state, processor, dispatcher, enable_accounting);
+            if (dispatcher) {
+                dispatcher->submitChunkEnd(state.chip_index, state.chunk_meta);
+            } else if (state.decode.collector) {
+                state.decode.collector->finishChunk(state.chip_index, state.chunk_meta);
+            }
+            state.in_chunk = false;
+        }
+    }
+    
+    // Flush any remaining batch at end of buffer
+    flushBatch(state, processor, dispatcher, enable_accounting);
+    
+    // Flush pending chunk count updates
+    if (state.pending_chunk_updates > 0) {
+        processor.incrementChunkCountBatch(state.pending_chunk_updates);
+        state.pending_chunk_updates = 0;
+    }
+    
+    if (reorder_buffer) {
+        const auto& reorder_stats = reorder_buffer->getStatistics();
+        processor.updateReorderStats(
+            reorder_stats.packets_reordered,
+            reorder_stats.max_reorder_distance,
+            reorder_stats.buffer_overflows,
+            reorder_stats.packets_dropped_too_old);
+    }
+}
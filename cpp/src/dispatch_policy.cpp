@@ -0,0 +1,131 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "dispatch_policy.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+constexpr double COST_SMOOTHING = 0.3;  // Weight of the newest inline window
+
+uint64_t to_ns(DispatchPolicy::Clock::time_point time) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+}
+
+uint64_t to_ns(std::chrono::milliseconds duration) {
+    return static_cast<uint64_t>(duration.count()) * 1000000ULL;
+}
+
+}  // namespace
+
+const char* decode_mode_name(DecodeMode mode) {
+    return mode == DecodeMode::Inline ? "inline" : "parallel";
+}
+
+DispatchPolicy::DispatchPolicy(DecodeMode initial) : DispatchPolicy(initial, Config{}) {}
+
+DispatchPolicy::DispatchPolicy(DecodeMode initial, const Config& config)
+    : config_(config), desired_(initial), current_(initial) {}
+
+void DispatchPolicy::recordBuffer(Clock::time_point start, Clock::time_point end, size_t words,
+                                  size_t queue_depth) {
+    uint64_t start_ns = to_ns(start);
+    uint64_t end_ns = to_ns(end);
+    if (window_start_ns_ == 0) {
+        window_start_ns_ = start_ns;
+    }
+    busy_ns_ += end_ns > start_ns ? end_ns - start_ns : 0;
+    words_ += words;
+    max_queue_depth_ = std::max(max_queue_depth_, queue_depth);
+    if (current_ == DecodeMode::Inline) {
+        inline_words_ += words;
+    } else {
+        parallel_words_ += words;
+    }
+
+    // A backlog behind an inline processing thread cannot wait for the window
+    bool backlog = current_ == DecodeMode::Inline && queue_depth >= config_.queue_high;
+    if (backlog || end_ns - window_start_ns_ >= to_ns(config_.window)) {
+        evaluate(end_ns);
+    }
+}
+
+void DispatchPolicy::evaluate(uint64_t now_ns) {
+    uint64_t elapsed_ns = std::max<uint64_t>(now_ns - window_start_ns_, 1);
+    double load = static_cast<double>(busy_ns_) / static_cast<double>(elapsed_ns);
+    bool settled = now_ns - last_switch_ns_ >= to_ns(config_.min_dwell);
+
+    if (current_ == DecodeMode::Inline) {
+        if (words_ > 0) {
+            double cost = static_cast<double>(busy_ns_) / static_cast<double>(words_);
+            inline_ns_per_word_ = inline_ns_per_word_ == 0.0
+                                      ? cost
+                                      : COST_SMOOTHING * cost + (1.0 - COST_SMOOTHING) * inline_ns_per_word_;
+        }
+        if (settled && (load >= config_.parallel_load || max_queue_depth_ >= config_.queue_high)) {
+            desired_ = DecodeMode::Parallel;
+            pending_ = Switch{DecodeMode::Parallel, load, max_queue_depth_};
+        }
+    } else if (inline_ns_per_word_ > 0.0) {
+        double projected = inline_ns_per_word_ * static_cast<double>(words_) / static_cast<double>(elapsed_ns);
+        if (settled && projected <= config_.inline_load && max_queue_depth_ < config_.queue_high) {
+            desired_ = DecodeMode::Inline;
+            pending_ = Switch{DecodeMode::Inline, projected, max_queue_depth_};
+        }
+    }
+
+    window_start_ns_ = now_ns;
+    busy_ns_ = 0;
+    words_ = 0;
+    max_queue_depth_ = 0;
+}
+
+void DispatchPolicy::applied(DecodeMode mode) {
+    if (mode == current_) {
+        return;
+    }
+    current_ = mode;
+    desired_ = mode;
+    latest_ = pending_;
+    latest_.mode = mode;
+    unreported_ = true;
+    ++switches_;
+    last_switch_ns_ = to_ns(Clock::now());
+    // The next window measures the new mode only
+    window_start_ns_ = last_switch_ns_;
+    busy_ns_ = 0;
+    words_ = 0;
+    max_queue_depth_ = 0;
+}
+
+bool DispatchPolicy::takeSwitch(Switch& latest) {
+    if (!unreported_) {
+        return false;
+    }
+    latest = latest_;
+    unreported_ = false;
+    return true;
+}
+
+std::string DispatchPolicy::describe() const {
+    std::ostringstream out;
+    uint64_t total = inline_words_ + parallel_words_;
+    out << "adaptive, " << switches_ << " switch(es), now " << decode_mode_name(current_);
+    if (total > 0) {
+        out << ", " << std::fixed << std::setprecision(1)
+            << (100.0 * static_cast<double>(inline_words_) / static_cast<double>(total)) << "% of words inline";
+    }
+    if (inline_ns_per_word_ > 0.0) {
+        out << ", inline cost " << std::fixed << std::setprecision(1) << inline_ns_per_word_ << " ns/word";
+    }
+    return out.str();
+}
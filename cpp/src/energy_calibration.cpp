@@ -0,0 +1,203 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "energy_calibration.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace {
+constexpr float UNCALIBRATED = std::numeric_limits<float>::quiet_NaN();
+}
+
+EnergyCalibration::EnergyCalibration()
+    : chips_(256), calibrated_pixels_(0), rejected_pixels_(0) {
+}
+
+bool EnergyCalibration::loadFromFile(const std::string& path, std::string& error) {
+    std::ifstream input(path);
+    if (!input) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(input, line)) {
+        ++line_number;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream fields(line);
+        unsigned chip, x, y;
+        float a, b, c, t;
+        if (!(fields >> chip)) {
+            continue;  // Blank or comment line
+        }
+        if (!(fields >> x >> y >> a >> b >> c >> t) || chip > 255 || x > 255 || y > 255) {
+            error = path + ":" + std::to_string(line_number) + ": expected 'chip x y a b c t'";
+            return false;
+        }
+        setPixel(static_cast<uint8_t>(chip), static_cast<uint16_t>(x), static_cast<uint16_t>(y), a, b, c, t);
+    }
+    if (calibrated_pixels_ == 0) {
+        error = "no valid pixel calibrations in " + path;
+        return false;
+    }
+    return true;
+}
+
+bool EnergyCalibration::setPixel(uint8_t chip, uint16_t x, uint16_t y, float a, float b, float c, float t) {
+    if (!(a > 0.0f) || !(c >= 0.0f) || !std::isfinite(b) || !std::isfinite(t) || x > 255 || y > 255) {
+        rejected_pixels_++;
+        return false;
+    }
+    ChipTable& table = chips_[chip];
+    if (table.scale.empty()) {
+        table.offset.assign(PIXELS_PER_CHIP, 0.0f);
+        table.center.assign(PIXELS_PER_CHIP, 0.0f);
+        table.discriminant.assign(PIXELS_PER_CHIP, 0.0f);
+        table.scale.assign(PIXELS_PER_CHIP, UNCALIBRATED);
+    }
+    size_t index = pixelIndex(x, y);
+    if (std::isnan(table.scale[index])) {
+        calibrated_pixels_++;
+    }
+    table.offset[index] = b - a * t;
+    table.center[index] = b + a * t;
+    table.discriminant[index] = 4.0f * a * c;
+    table.scale[index] = 1.0f / (2.0f * a);
+    return true;
+}
+
+size_t EnergyCalibration::calibratedChips() const {
+    size_t count = 0;
+    for (const auto& table : chips_) {
+        if (!table.scale.empty()) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void EnergyCalibration::apply(HitBlock& block, Scratch& scratch) const {
+    const size_t n = block.size();
+    scratch.tot.resize(n);
+    scratch.offset.resize(n);
+    scratch.center.resize(n);
+    scratch.discriminant.resize(n);
+    scratch.scale.resize(n);
+    block.energy.resize(n);
+
+    // Gather per-pixel coefficients (random access into the chip tables)
+    const float counts_per_ns = 1.0f / TOT_NS_PER_COUNT;
+    for (size_t i = 0; i < n; ++i) {
+        scratch.tot[i] = static_cast<float>(block.tot[i]) * counts_per_ns;
+        const ChipTable& table = chips_[block.chip[i]];
+        if (table.scale.empty()) {
+            scratch.offset[i] = 0.0f;
+            scratch.center[i] = 0.0f;
+            scratch.discriminant[i] = 0.0f;
+            scratch.scale[i] = UNCALIBRATED;
+            continue;
+        }
+        size_t index = pixelIndex(block.x[i], block.y[i]);
+        scratch.offset[i] = table.offset[index];
+        scratch.center[i] = table.center[index];
+        scratch.discriminant[i] = table.discriminant[index];
+        scratch.scale[i] = table.scale[index];
+    }
+
+    // Branch-free inverse surrogate over contiguous columns (vectorizes).
+    // The discriminant is non-negative because a > 0 and c >= 0.
+    const float* tot = scratch.tot.data();
+    const float* offset = scratch.offset.data();
+    const float* center = scratch.center.data();
+    const float* discriminant = scratch.discriminant.data();
+    const float* scale = scratch.scale.data();
+    float* energy = block.energy.data();
+    for (size_t i = 0; i < n; ++i) {
+        float d = tot[i] - center[i];
+        energy[i] = (tot[i] - offset[i] + std::sqrt(d * d + discriminant[i])) * scale[i];
+    }
+}
+
+void EnergySpectrum::configure(size_t bin_count, double bin_width) {
+    bin_width_kev = bin_width;
+    bins.assign(std::max<size_t>(1, bin_count) + 1, 0);
+    chip_energy_kev.assign(256, 0.0);
+    chip_weighted_x.assign(256, 0.0);
+    chip_weighted_y.assign(256, 0.0);
+    chip_hits.assign(256, 0);
+    uncalibrated_hits = 0;
+}
+
+void EnergySpectrum::add(const HitBlock& block) {
+    if (bins.empty()) {
+        configure(1000, bin_width_kev);
+    }
+    const double inv_width = 1.0 / bin_width_kev;
+    const size_t overflow = bins.size() - 1;
+    for (size_t i = 0; i < block.size(); ++i) {
+        float e = block.energy[i];
+        if (std::isnan(e)) {
+            uncalibrated_hits++;
+            continue;
+        }
+        double energy = std::max(0.0f, e);
+        size_t bin = static_cast<size_t>(energy * inv_width);
+        bins[std::min(bin, overflow)]++;
+        uint8_t chip = block.chip[i];
+        chip_energy_kev[chip] += energy;
+        chip_weighted_x[chip] += energy * block.x[i];
+        chip_weighted_y[chip] += energy * block.y[i];
+        chip_hits[chip]++;
+    }
+}
+
+void EnergySpectrum::merge(const EnergySpectrum& other) {
+    if (other.bins.empty()) {
+        return;
+    }
+    if (bins.empty()) {
+        *this = other;
+        return;
+    }
+    for (size_t i = 0; i < bins.size() && i < other.bins.size(); ++i) {
+        bins[i] += other.bins[i];
+    }
+    for (size_t chip = 0; chip < chip_hits.size(); ++chip) {
+        chip_energy_kev[chip] += other.chip_energy_kev[chip];
+        chip_weighted_x[chip] += other.chip_weighted_x[chip];
+        chip_weighted_y[chip] += other.chip_weighted_y[chip];
+        chip_hits[chip] += other.chip_hits[chip];
+    }
+    uncalibrated_hits += other.uncalibrated_hits;
+}
+
+uint64_t EnergySpectrum::totalHits() const {
+    uint64_t total = 0;
+    for (uint64_t count : chip_hits) {
+        total += count;
+    }
+    return total;
+}
+
+bool EnergySpectrum::writeCsv(const std::string& path) const {
+    std::ofstream output(path);
+    if (!output) {
+        return false;
+    }
+    output << "energy_kev,count\n";
+    for (size_t i = 0; i < bins.size(); ++i) {
+        output << (static_cast<double>(i) * bin_width_kev) << "," << bins[i] << "\n";
+    }
+    return static_cast<bool>(output);
+}
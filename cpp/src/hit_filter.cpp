@@ -0,0 +1,172 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "hit_filter.h"
+#include <algorithm>
+
+void Tdc1History::snapshot(uint64_t begin, uint64_t end, std::vector<uint64_t>& out) const {
+    out.clear();
+    uint64_t count = count_.load(std::memory_order_acquire);
+    uint64_t oldest = count > CAPACITY ? count - CAPACITY : 0;
+    auto at = [this](uint64_t index) {
+        return entries_[index % CAPACITY].load(std::memory_order_relaxed);
+    };
+    // First entry at or after `begin`
+    uint64_t lo = oldest;
+    uint64_t hi = count;
+    while (lo < hi) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        if (at(mid) < begin) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    uint64_t first = lo > oldest ? lo - 1 : lo;
+    for (uint64_t index = first; index < count; ++index) {
+        uint64_t timestamp = at(index);
+        if (timestamp > end) {
+            break;
+        }
+        out.push_back(timestamp);
+    }
+    // Entries overwritten while reading belong to a reader lagging the
+    // writer by a full ring; drop whatever is no longer consistent
+    uint64_t still_valid = count_.load(std::memory_order_acquire);
+    if (still_valid > CAPACITY && still_valid - CAPACITY > first) {
+        out.clear();
+    }
+}
+
+void HitFilter::Statistics::merge(const Statistics& other) {
+    hits_in += other.hits_in;
+    roi_rejected += other.roi_rejected;
+    tot_rejected += other.tot_rejected;
+    tof_rejected += other.tof_rejected;
+    hits_passed += other.hits_passed;
+}
+
+HitFilter::HitFilter()
+    : rois_(256),
+      has_roi_(false),
+      has_tot_(false),
+      has_tof_(false),
+      tot_min_ns_(0),
+      tot_max_ns_(UINT16_MAX),
+      tof_min_ticks_(0),
+      tof_max_ticks_(UINT64_MAX) {
+}
+
+void HitFilter::addRoi(uint8_t chip, const Roi& roi) {
+    rois_[chip].push_back(roi);
+    has_roi_ = true;
+}
+
+void HitFilter::setTotWindow(uint16_t min_ns, uint16_t max_ns) {
+    tot_min_ns_ = min_ns;
+    tot_max_ns_ = max_ns;
+    has_tot_ = true;
+}
+
+void HitFilter::setTofWindow(uint64_t min_ticks, uint64_t max_ticks) {
+    tof_min_ticks_ = min_ticks;
+    tof_max_ticks_ = max_ticks;
+    has_tof_ = true;
+}
+
+namespace {
+
+size_t count_kept(const std::vector<uint8_t>& keep, size_t n) {
+    size_t kept = 0;
+    for (size_t i = 0; i < n; ++i) {
+        kept += keep[i];
+    }
+    return kept;
+}
+
+}  // namespace
+
+void HitFilter::apply(HitBlock& block, Scratch& scratch, Statistics& stats) const {
+    const size_t n = block.size();
+    if (n == 0) {
+        return;
+    }
+    stats.hits_in += n;
+    scratch.keep.assign(n, 1);
+    uint8_t* keep = scratch.keep.data();
+    size_t kept = n;
+
+    if (has_roi_) {
+        // Chunk runs hold one chip, so this is normally a single segment
+        scratch.inside.assign(n, 0);
+        uint8_t* inside = scratch.inside.data();
+        const uint16_t* x = block.x.data();
+        const uint16_t* y = block.y.data();
+        size_t begin = 0;
+        while (begin < n) {
+            uint8_t chip = block.chip[begin];
+            size_t end = begin + 1;
+            while (end < n && block.chip[end] == chip) {
+                ++end;
+            }
+            for (const Roi& roi : rois_[chip]) {
+                for (size_t i = begin; i < end; ++i) {
+                    inside[i] |= static_cast<uint8_t>((x[i] >= roi.x_min) & (x[i] <= roi.x_max) &
+                                                      (y[i] >= roi.y_min) & (y[i] <= roi.y_max));
+                }
+            }
+            begin = end;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            keep[i] &= inside[i];
+        }
+        size_t passed = count_kept(scratch.keep, n);
+        stats.roi_rejected += kept - passed;
+        kept = passed;
+    }
+
+    if (has_tot_) {
+        const uint16_t* tot = block.tot.data();
+        const uint16_t lo = tot_min_ns_;
+        const uint16_t hi = tot_max_ns_;
+        for (size_t i = 0; i < n; ++i) {
+            keep[i] &= static_cast<uint8_t>((tot[i] >= lo) & (tot[i] <= hi));
+        }
+        size_t passed = count_kept(scratch.keep, n);
+        stats.tot_rejected += kept - passed;
+        kept = passed;
+    }
+
+    if (has_tof_) {
+        const uint64_t* toa = block.toa.data();
+        auto range = std::minmax_element(block.toa.begin(), block.toa.end());
+        tdc1_.snapshot(*range.first, *range.second, scratch.tdc1);
+        const uint64_t lo = tof_min_ticks_;
+        const uint64_t hi = tof_max_ticks_;
+        for (size_t i = 0; i < n; ++i) {
+            // Latest TDC1 at or before the hit (a block spans few TDC1 periods)
+            uint64_t reference = 0;
+            uint8_t found = 0;
+            for (uint64_t tdc1 : scratch.tdc1) {
+                uint8_t after = toa[i] >= tdc1;
+                reference = after ? tdc1 : reference;
+                found |= after;
+            }
+            uint64_t tof = toa[i] - reference;
+            keep[i] &= static_cast<uint8_t>(found & (tof >= lo) & (tof <= hi));
+        }
+        size_t passed = count_kept(scratch.keep, n);
+        stats.tof_rejected += kept - passed;
+        kept = passed;
+    }
+
+    stats.hits_passed += kept;
+    if (kept != n) {
+        block.compact(scratch.keep);
+    }
+}
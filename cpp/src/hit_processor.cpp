@@ -9,9 +9,11 @@
 #include "hit_processor.h"
 #include <chrono>
 #include <limits>
+#include <algorithm>
 
-HitProcessor::HitProcessor()
-    : recent_hit_capacity_(10),
+HitProcessor::HitProcessor(size_t chip_count)
+    : chip_count_(std::min(std::max<size_t>(chip_count, 1), MAX_CHIP_COUNT)),
+      recent_hit_capacity_(10),
       recent_hits_buffer_(recent_hit_capacity_),
       recent_hits_head_(0),
       recent_hits_size_(0) {
@@ -36,12 +38,13 @@ void HitProcessor::resetStatistics() {
     stats_.cumulative_hit_rate_hz = 0.0;
     stats_.cumulative_tdc1_rate_hz = 0.0;
     stats_.cumulative_tdc2_rate_hz = 0.0;
-    stats_.chip_hit_rates_hz.fill(0.0);
-    stats_.chip_hit_rate_valid.fill(false);
-    stats_.chip_tdc1_counts.fill(0);
-    stats_.chip_tdc1_rates_hz.fill(0.0);
-    stats_.chip_tdc1_cumulative_rates_hz.fill(0.0);
-    stats_.chip_tdc1_present.fill(false);
+    stats_.chip_hit_rates_hz.assign(chip_count_, 0.0);
+    stats_.chip_hit_rate_valid.assign(chip_count_, false);
+    stats_.chip_tdc1_counts.assign(chip_count_, 0);
+    stats_.chip_tdc1_rates_hz.assign(chip_count_, 0.0);
+    stats_.chip_tdc1_cumulative_rates_hz.assign(chip_count_, 0.0);
+    stats_.chip_tdc1_present.assign(chip_count_, false);
+    stats_.chip_index_out_of_range = 0;
     stats_.packet_byte_totals.clear();
     stats_.total_bytes_accounted = 0;
     stats_.earliest_hit_time_ticks = std::numeric_limits<uint64_t>::max();
@@ -66,11 +69,17 @@ void HitProcessor::resetStatistics() {
     last_tdc1_time_ticks_ = 0;
     recent_hits_head_ = 0;
     recent_hits_size_ = 0;
-    chip_hit_totals_.fill(0);
-    chip_hits_at_last_update_.fill(0);
-    chip_tdc1_at_last_update_.fill(0);
-    chip_tdc1_min_ticks_.fill(std::numeric_limits<uint64_t>::max());
-    chip_tdc1_max_ticks_.fill(0);
+    chip_hit_totals_.assign(chip_count_, 0);
+    chip_hits_at_last_update_.assign(chip_count_, 0);
+    chip_tdc1_at_last_update_.assign(chip_count_, 0);
+    chip_tdc1_min_ticks_.assign(chip_count_, std::numeric_limits<uint64_t>::max());
+    chip_tdc1_max_ticks_.assign(chip_count_, 0);
+}
+
+void HitProcessor::setChipCount(size_t chip_count) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    chip_count_ = std::min(std::max<size_t>(chip_count, 1), MAX_CHIP_COUNT);
+    resetStatistics();
 }
 
 void HitProcessor::setRecentHitCapacity(size_t capacity) {
@@ -127,6 +136,8 @@ void HitProcessor::addHit(const PixelHit& hit) {
     if (hit.chip_index < chip_hit_totals_.size()) {
         chip_hit_totals_[hit.chip_index]++;
         stats_.chip_hit_rate_valid[hit.chip_index] = true;
+    } else {
+        stats_.chip_index_out_of_range++;
     }
 
     if (start_time_ns_ == 0) {
@@ -187,10 +198,15 @@ void HitProcessor::addTdcEvent(const TDCEvent& tdc, uint8_t chip_index) {
             if (tdc.timestamp_ns > max_entry) {
                 max_entry = tdc.timestamp_ns;
             }
+        } else {
+            stats_.chip_index_out_of_range++;
         }
     }
     if (tdc.type == TDC2_RISE || tdc.type == TDC2_FALL) {
         stats_.total_tdc2_events++;
+        if (chip_index >= stats_.chip_tdc1_counts.size()) {
+            stats_.chip_index_out_of_range++;
+        }
     }
 
     updateHitRate();
@@ -0,0 +1,92 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "hit_sort.h"
+#include <array>
+#include <cstring>
+
+namespace {
+constexpr unsigned DIGIT_BITS = 11;
+constexpr size_t BUCKETS = size_t(1) << DIGIT_BITS;
+constexpr unsigned MAX_PASSES = (32 + DIGIT_BITS - 1) / DIGIT_BITS;
+// Below this the comparison sort wins (histogram setup dominates)
+constexpr size_t RADIX_MIN_HITS = 128;
+}
+
+void radix_sort_hits_by_toa(HitBlock& block, HitSortScratch& scratch) {
+    const size_t n = block.size();
+    if (n < 2) {
+        return;
+    }
+    
+    const uint64_t* toa = block.toa.data();
+    uint64_t min_toa = toa[0];
+    uint64_t max_toa = toa[0];
+    size_t descents = 0;
+    for (size_t i = 1; i < n; ++i) {
+        min_toa = toa[i] < min_toa ? toa[i] : min_toa;
+        max_toa = toa[i] > max_toa ? toa[i] : max_toa;
+        descents += toa[i] < toa[i - 1];
+    }
+    if (descents == 0) {
+        return;
+    }
+    
+    uint64_t range = max_toa - min_toa;
+    if (n < RADIX_MIN_HITS || (range >> 32) != 0 || n > UINT32_MAX) {
+        sort_hits_by_toa(block);
+        return;
+    }
+    
+    unsigned key_bits = 64 - __builtin_clzll(range);
+    unsigned passes = (key_bits + DIGIT_BITS - 1) / DIGIT_BITS;
+    
+    // Pack (relative ToA << 32 | index) so one array carries key and payload,
+    // and build all digit histograms in the same pass
+    scratch.keys.resize(n);
+    scratch.temp.resize(n);
+    uint64_t* keys = scratch.keys.data();
+    std::array<std::array<uint32_t, BUCKETS>, MAX_PASSES> counts;
+    for (unsigned p = 0; p < passes; ++p) {
+        counts[p].fill(0);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t rel = toa[i] - min_toa;
+        keys[i] = (rel << 32) | i;
+        for (unsigned p = 0; p < passes; ++p) {
+            counts[p][(rel >> (p * DIGIT_BITS)) & (BUCKETS - 1)]++;
+        }
+    }
+    
+    uint64_t* src = scratch.keys.data();
+    uint64_t* dst = scratch.temp.data();
+    for (unsigned p = 0; p < passes; ++p) {
+        unsigned shift = 32 + p * DIGIT_BITS;
+        auto& count = counts[p];
+        if (count[(src[0] >> shift) & (BUCKETS - 1)] == n) {
+            continue;  // Every key has the same digit
+        }
+        uint32_t offset = 0;
+        for (size_t b = 0; b < BUCKETS; ++b) {
+            uint32_t c = count[b];
+            count[b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t v = src[i];
+            dst[count[(v >> shift) & (BUCKETS - 1)]++] = v;
+        }
+        std::swap(src, dst);
+    }
+    
+    scratch.order.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        scratch.order[i] = static_cast<uint32_t>(src[i]);
+    }
+    block.permute(scratch.order);
+}
@@ -0,0 +1,82 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "latency_histogram.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+uint64_t LatencyHistogram::bucketUpperNs(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    int exponent = static_cast<int>(index / SUB_BUCKETS) + SUB_BITS - 1;
+    uint64_t sub = index % SUB_BUCKETS;
+    int shift = exponent - SUB_BITS;
+    uint64_t low = (SUB_BUCKETS + sub) << shift;
+    return low + ((1ULL << shift) - 1);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot snapshot;
+    snapshot.counts.resize(BUCKETS);
+    uint64_t total = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        snapshot.counts[i] = counts_[i].load(std::memory_order_relaxed);
+        total += snapshot.counts[i];
+    }
+    // Bucket counts are the reference; count/sum may be a record ahead
+    snapshot.count = total;
+    snapshot.sum_ns = sum_ns_.load(std::memory_order_relaxed);
+    snapshot.max_ns = max_ns_.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+void LatencyHistogram::Snapshot::merge(const Snapshot& other) {
+    if (counts.empty()) {
+        counts.assign(BUCKETS, 0);
+    }
+    for (size_t i = 0; i < other.counts.size(); ++i) {
+        counts[i] += other.counts[i];
+    }
+    count += other.count;
+    sum_ns += other.sum_ns;
+    max_ns = std::max(max_ns, other.max_ns);
+}
+
+uint64_t LatencyHistogram::Snapshot::percentileNs(double quantile) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(quantile * static_cast<double>(count));
+    rank = std::min(std::max<uint64_t>(rank, 1), count);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(bucketUpperNs(i), max_ns);
+        }
+    }
+    return max_ns;
+}
+
+void print_latency_line(const std::string& label, const LatencyHistogram::Snapshot& snapshot) {
+    auto us = [](double ns) { return ns / 1000.0; };
+    std::cout << "  " << std::left << std::setw(20) << label << std::right;
+    if (snapshot.count == 0) {
+        std::cout << "no samples" << std::endl;
+        return;
+    }
+    std::cout << std::fixed << std::setprecision(1) << "n=" << snapshot.count
+              << " mean=" << us(snapshot.meanNs())
+              << " p50=" << us(static_cast<double>(snapshot.percentileNs(0.50)))
+              << " p90=" << us(static_cast<double>(snapshot.percentileNs(0.90)))
+              << " p99=" << us(static_cast<double>(snapshot.percentileNs(0.99)))
+              << " p99.9=" << us(static_cast<double>(snapshot.percentileNs(0.999)))
+              << " max=" << us(static_cast<double>(snapshot.max_ns)) << " us" << std::endl;
+}
@@ -7,13 +7,14 @@
  */
 
 #include "tcp_server.h"
-#include "tpx3_decoder.h"
-#include "timestamp_extension.h"
-#include "hit_processor.h"
-#include "tpx3_packets.h"
-#include "packet_reorder_buffer.h"
+#include "decode_pipeline.h"
+#include "queue_telemetry.h"
+#include "stats_publisher.h"
+#include "metrics_server.h"
+#include "thread_affinity.h"
 
 #include <iostream>
+#include <cstdio>
 #include <cstring>
 #include <iomanip>
 #include <string>
@@ -29,734 +30,6 @@
 #include <filesystem>
 #include <system_error>
 #include <thread>
-#include <condition_variable>
-#include <queue>
-
-static std::string format_type_label(const std::string& prefix, uint8_t type) {
-    std::ostringstream oss;
-    oss << prefix << " (0x" << std::hex << std::uppercase << std::setfill('0')
-        << std::setw(2) << static_cast<int>(type) << ")";
-    return oss.str();
-}
-
-void process_packet(uint64_t word, uint8_t chip_index, HitProcessor& processor, const ChunkMetadata& chunk_meta, bool enable_accounting = true);
-
-struct StreamState {
-    bool in_chunk = false;
-    size_t chunk_words_remaining = 0;
-    uint8_t chip_index = 0;
-    uint64_t current_chunk_id = 0;
-    uint64_t local_chunk_count = 0;  // Local counter to avoid mutex locks
-    uint64_t pending_chunk_updates = 0;  // Batch chunk count updates
-    ChunkMetadata chunk_meta{};
-    std::vector<ExtraTimestamp> extra_timestamps;
-    bool saw_first_chunk_header = false;
-    bool mid_stream_flagged = false;
-    std::vector<uint64_t> batch_buffer;  // Batch buffer for dispatcher submissions
-
-    StreamState() {
-        extra_timestamps.reserve(3);
-        batch_buffer.reserve(128);  // Pre-allocate batch buffer
-    }
-};
-
-struct DecodeTask {
-    uint64_t word = 0;
-    uint8_t chip_index = 0;
-    ChunkMetadata chunk_meta{};
-};
-
-// Thread-safe queue for raw data buffers between network and processing threads
-class RawDataQueue {
-public:
-    struct Buffer {
-        std::vector<uint8_t> data;
-        size_t size = 0;
-        
-        Buffer() = default;
-        Buffer(const uint8_t* src, size_t len) : data(src, src + len), size(len) {}
-    };
-    
-    RawDataQueue(size_t max_buffers = 100) 
-        : max_buffers_(max_buffers), 
-          stop_(false),
-          dropped_buffers_(0) {}
-    
-    // Push a buffer (non-blocking, drops if full)
-    // Returns true if successfully enqueued, false if dropped
-    bool push(const uint8_t* data, size_t size) {
-        if (stop_.load(std::memory_order_acquire)) {
-            return false;
-        }
-        
-        std::unique_lock<std::mutex> lock(mutex_);
-        
-        // Drop oldest buffer if queue is full (flow control)
-        if (queue_.size() >= max_buffers_) {
-            queue_.pop();
-            dropped_buffers_.fetch_add(1, std::memory_order_relaxed);
-        }
-        
-        queue_.emplace(data, size);
-        lock.unlock();
-        cond_.notify_one();
-        return true;
-    }
-    
-    // Pop a buffer (blocking with timeout)
-    // Returns true if buffer was retrieved, false if timeout or stopped
-    bool pop(Buffer& buffer, std::chrono::milliseconds timeout = std::chrono::milliseconds(100)) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        
-        bool notified = cond_.wait_for(lock, timeout, [this]() {
-            return !queue_.empty() || stop_.load(std::memory_order_acquire);
-        });
-        
-        if (!notified || queue_.empty()) {
-            return false;
-        }
-        
-        buffer = std::move(queue_.front());
-        queue_.pop();
-        return true;
-    }
-    
-    // Signal shutdown
-    void stop() {
-        stop_.store(true, std::memory_order_release);
-        std::lock_guard<std::mutex> lock(mutex_);
-        cond_.notify_all();
-    }
-    
-    // Check if stopped
-    bool isStopped() const {
-        return stop_.load(std::memory_order_acquire);
-    }
-    
-    // Get number of dropped buffers
-    uint64_t getDroppedBuffers() const {
-        return dropped_buffers_.load(std::memory_order_acquire);
-    }
-    
-    // Get current queue size (approximate)
-    size_t size() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.size();
-    }
-    
-private:
-    mutable std::mutex mutex_;
-    std::condition_variable cond_;
-    std::queue<Buffer> queue_;
-    size_t max_buffers_;
-    std::atomic<bool> stop_;
-    std::atomic<uint64_t> dropped_buffers_;
-};
-
-class DecodeDispatcher {
-public:
-    struct PartialStats {
-        uint64_t hits = 0;
-        uint64_t tdc1 = 0;
-        uint64_t tdc2 = 0;
-        uint64_t earliest_hit_tick = std::numeric_limits<uint64_t>::max();
-        uint64_t latest_hit_tick = 0;
-        uint64_t earliest_tdc1_tick = std::numeric_limits<uint64_t>::max();
-        uint64_t latest_tdc1_tick = 0;
-        std::array<uint64_t, 4> chip_hits{};
-        std::array<uint64_t, 4> chip_tdc1{};
-        std::array<uint64_t, 4> chip_tdc2{};
-        std::array<uint64_t, 4> chip_tdc1_min{};
-        std::array<uint64_t, 4> chip_tdc1_max{};
-        std::vector<PixelHit> recent_hits;
-
-        void mergeInto(HitProcessor& processor) {
-            if (hits == 0 && tdc1 == 0 && tdc2 == 0 && recent_hits.empty()) {
-                return;
-            }
-            std::lock_guard<std::recursive_mutex> lock(processor.mutex_);
-            processor.stats_.total_hits += hits;
-            processor.stats_.total_tdc1_events += tdc1;
-            processor.stats_.total_tdc2_events += tdc2;
-            processor.stats_.total_tdc_events += (tdc1 + tdc2);
-            for (size_t chip = 0; chip < 4; ++chip) {
-                processor.chip_hit_totals_[chip] += chip_hits[chip];
-                processor.stats_.chip_hit_rate_valid[chip] =
-                    processor.stats_.chip_hit_rate_valid[chip] || chip_hits[chip] > 0;
-                processor.stats_.chip_tdc1_counts[chip] += chip_tdc1[chip];
-                if (chip_tdc1[chip] > 0) {
-                    processor.stats_.chip_tdc1_present[chip] = true;
-                    processor.chip_tdc1_min_ticks_[chip] =
-                        std::min(processor.chip_tdc1_min_ticks_[chip], chip_tdc1_min[chip]);
-                    processor.chip_tdc1_max_ticks_[chip] =
-                        std::max(processor.chip_tdc1_max_ticks_[chip], chip_tdc1_max[chip]);
-                }
-            }
-            if (hits > 0) {
-                if (!processor.stats_.hit_time_initialized ||
-                    earliest_hit_tick < processor.stats_.earliest_hit_time_ticks) {
-                    processor.stats_.earliest_hit_time_ticks = earliest_hit_tick;
-                    processor.stats_.hit_time_initialized = true;
-                }
-                if (latest_hit_tick > processor.stats_.latest_hit_time_ticks) {
-                    processor.stats_.latest_hit_time_ticks = latest_hit_tick;
-                }
-            }
-            if (tdc1 > 0) {
-                if (!processor.stats_.tdc1_time_initialized ||
-                    earliest_tdc1_tick < processor.stats_.earliest_tdc1_time_ticks) {
-                    processor.stats_.earliest_tdc1_time_ticks = earliest_tdc1_tick;
-                    processor.stats_.tdc1_time_initialized = true;
-                }
-                if (latest_tdc1_tick > processor.stats_.latest_tdc1_time_ticks) {
-                    processor.stats_.latest_tdc1_time_ticks = latest_tdc1_tick;
-                }
-            }
-            if (processor.recent_hit_capacity_ > 0) {
-                for (const auto& hit : recent_hits) {
-                    if (processor.recent_hits_buffer_.size() != processor.recent_hit_capacity_) {
-                        processor.recent_hits_buffer_.assign(
-                            processor.recent_hit_capacity_, PixelHit{});
-                    }
-                    processor.recent_hits_buffer_[processor.recent_hits_head_] = hit;
-                    processor.recent_hits_head_ =
-                        (processor.recent_hits_head_ + 1) % processor.recent_hit_capacity_;
-                    if (processor.recent_hits_size_ < processor.recent_hit_capacity_) {
-                        processor.recent_hits_size_++;
-                    }
-                }
-            }
-        }
-
-        void reset(size_t recent_capacity) {
-            hits = tdc1 = tdc2 = 0;
-            earliest_hit_tick = std::numeric_limits<uint64_t>::max();
-            latest_hit_tick = 0;
-            earliest_tdc1_tick = std::numeric_limits<uint64_t>::max();
-            latest_tdc1_tick = 0;
-            chip_hits.fill(0);
-            chip_tdc1.fill(0);
-            chip_tdc2.fill(0);
-            chip_tdc1_min.fill(std::numeric_limits<uint64_t>::max());
-            chip_tdc1_max.fill(0);
-            recent_hits.clear();
-            if (recent_capacity > 0) {
-                recent_hits.reserve(recent_capacity);
-            }
-        }
-    };
-
-    DecodeDispatcher(size_t num_workers, HitProcessor& processor, size_t recent_cap)
-        : processor_(processor),
-          stop_(false),
-          pending_tasks_(0),
-          recent_capacity_(recent_cap) {
-        size_t workers = std::max<size_t>(1, num_workers);
-        worker_data_.reserve(workers);
-        for (size_t i = 0; i < workers; ++i) {
-            worker_data_.emplace_back(std::make_unique<WorkerData>(recent_capacity_));
-        }
-        workers_.reserve(workers);
-        for (size_t i = 0; i < workers; ++i) {
-            workers_.emplace_back([this, i]() { workerLoop(i); });
-        }
-    }
-
-    ~DecodeDispatcher() { stop(); }
-
-    void submit(uint64_t word, uint8_t chip_index, const ChunkMetadata& meta) {
-        size_t index = chip_index % worker_data_.size();
-        pending_tasks_.fetch_add(1, std::memory_order_release);
-        auto& data = *worker_data_[index];
-        {
-            std::lock_guard<std::mutex> lock(data.mutex);
-            data.queue.push(DecodeTask{word, chip_index, meta});
-        }
-        // Notify worker (notify_one is cheap, and ensures workers stay responsive)
-        data.cond.notify_one();
-    }
-
-    // Batch submit multiple words to reduce mutex contention
-    void submitBatch(const std::vector<uint64_t>& words, uint8_t chip_index, const ChunkMetadata& meta) {
-        if (words.empty()) return;
-        size_t index = chip_index % worker_data_.size();
-        pending_tasks_.fetch_add(words.size(), std::memory_order_release);
-        auto& data = *worker_data_[index];
-        {
-            std::lock_guard<std::mutex> lock(data.mutex);
-            for (uint64_t word : words) {
-                data.queue.push(DecodeTask{word, chip_index, meta});
-            }
-        }
-        // Only notify once after batch submission
-        data.cond.notify_one();
-    }
-
-    void waitUntilIdle() {
-        std::unique_lock<std::mutex> lock(pending_mutex_);
-        idle_cv_.wait(lock, [this]() {
-            return pending_tasks_.load(std::memory_order_acquire) == 0;
-        });
-        flushAll();
-    }
-
-    void stop() {
-        bool expected = false;
-        if (!stop_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
-            return;
-        }
-        for (auto& data : worker_data_) {
-            data->cond.notify_all();
-        }
-        for (auto& worker : workers_) {
-            if (worker.joinable()) {
-                worker.join();
-            }
-        }
-        workers_.clear();
-        flushAll();
-    }
-
-    void flushAll() {
-        for (auto& data : worker_data_) {
-            flushWorker(*data);
-        }
-    }
-
-private:
-    struct WorkerData {
-        explicit WorkerData(size_t recent_capacity) : stats() {
-            stats.reset(recent_capacity);
-        }
-        std::mutex mutex;
-        std::condition_variable cond;
-        std::queue<DecodeTask> queue;
-        std::mutex stats_mutex;
-        PartialStats stats;
-    };
-
-    HitProcessor& processor_;
-    std::vector<std::thread> workers_;
-    std::vector<std::unique_ptr<WorkerData>> worker_data_;
-    std::atomic<bool> stop_;
-    std::atomic<size_t> pending_tasks_;
-    std::mutex pending_mutex_;
-    std::condition_variable idle_cv_;
-    size_t recent_capacity_;
-
-    void workerLoop(size_t index) {
-        while (true) {
-            DecodeTask task;
-            {
-                auto& data = *worker_data_[index];
-                std::unique_lock<std::mutex> lock(data.mutex);
-                data.cond.wait(lock, [this, &data]() {
-                    return stop_.load(std::memory_order_acquire) || !data.queue.empty();
-                });
-
-                if (stop_.load(std::memory_order_acquire) && data.queue.empty()) {
-                    break;
-                }
-
-                if (!data.queue.empty()) {
-                    task = data.queue.front();
-                    data.queue.pop();
-                } else {
-                    continue;
-                }
-            }
-
-            processDecoded(task, *worker_data_[index]);
-
-            size_t remaining =
-                pending_tasks_.fetch_sub(1, std::memory_order_acq_rel) - 1;
-            if (remaining == 0) {
-                std::lock_guard<std::mutex> lock(pending_mutex_);
-                idle_cv_.notify_all();
-            }
-        }
-    }
-
-    void processDecoded(const DecodeTask& task, WorkerData& data) {
-        PartialStats& stats = data.stats;
-        uint8_t full_type = (task.word >> 56) & 0xFF;
-        if (full_type == SPIDR_PACKET_ID || full_type == TPX3_CONTROL ||
-            full_type == EXTRA_TIMESTAMP || full_type == EXTRA_TIMESTAMP_MPX3 ||
-            full_type == GLOBAL_TIME_LOW || full_type == GLOBAL_TIME_HIGH) {
-            process_packet(task.word, task.chip_index, processor_, task.chunk_meta);
-            return;
-        }
-        uint8_t packet_type = (task.word >> 60) & 0xF;
-        switch (packet_type) {
-            case PIXEL_COUNT_FB:
-            case PIXEL_STANDARD: {
-                try {
-                    PixelHit hit = decode_pixel_data(task.word, task.chip_index);
-                    if (task.chunk_meta.has_extra_packets) {
-                        uint64_t truncated_toa = hit.toa_ns & 0x3FFFFFFF;
-                        hit.toa_ns =
-                            extend_timestamp(truncated_toa, task.chunk_meta.min_timestamp_ns, 30);
-                    }
-                    std::lock_guard<std::mutex> lock(data.stats_mutex);
-                    stats.hits++;
-                    stats.chip_hits[hit.chip_index]++;
-                    stats.earliest_hit_tick =
-                        std::min(stats.earliest_hit_tick, hit.toa_ns);
-                    stats.latest_hit_tick =
-                        std::max(stats.latest_hit_tick, hit.toa_ns);
-                    if (recent_capacity_ > 0 &&
-                        stats.recent_hits.size() < recent_capacity_) {
-                        stats.recent_hits.push_back(hit);
-                    }
-                } catch (...) {
-                    process_packet(task.word, task.chip_index, processor_, task.chunk_meta);
-                }
-                break;
-            }
-            case TDC_DATA: {
-                try {
-                    TDCEvent tdc = decode_tdc_data(task.word);
-                    std::lock_guard<std::mutex> lock(data.stats_mutex);
-                    if (tdc.type == TDC1_RISE || tdc.type == TDC1_FALL) {
-                        stats.tdc1++;
-                        stats.chip_tdc1[task.chip_index]++;
-                        stats.earliest_tdc1_tick =
-                            std::min(stats.earliest_tdc1_tick, tdc.timestamp_ns);
-                        stats.latest_tdc1_tick =
-                            std::max(stats.latest_tdc1_tick, tdc.timestamp_ns);
-                        stats.chip_tdc1_min[task.chip_index] =
-                            std::min(stats.chip_tdc1_min[task.chip_index], tdc.timestamp_ns);
-                        stats.chip_tdc1_max[task.chip_index] =
-                            std::max(stats.chip_tdc1_max[task.chip_index], tdc.timestamp_ns);
-                    } else if (tdc.type == TDC2_RISE || tdc.type == TDC2_FALL) {
-                        stats.tdc2++;
-                        stats.chip_tdc2[task.chip_index]++;
-                    }
-                } catch (...) {
-                    process_packet(task.word, task.chip_index, processor_, task.chunk_meta);
-                }
-                break;
-            }
-            default:
-                process_packet(task.word, task.chip_index, processor_, task.chunk_meta);
-                break;
-        }
-    }
-
-    void flushWorker(WorkerData& data) {
-        PartialStats local;
-        {
-            std::lock_guard<std::mutex> lock(data.stats_mutex);
-            local = data.stats;
-            data.stats.reset(recent_capacity_);
-        }
-        local.mergeInto(processor_);
-    }
-};
-
-// Helper function to process a single packet (used by reorder buffer callback)
-void process_packet(uint64_t word, uint8_t chip_index, HitProcessor& processor, const ChunkMetadata& chunk_meta, bool enable_accounting) {
-    // Check full-byte types first (0x50, 0x71, etc. that can't be distinguished by 4-bit)
-    uint8_t full_type = (word >> 56) & 0xFF;
-    
-    if (full_type == SPIDR_PACKET_ID) {
-        if (enable_accounting) {
-            processor.addPacketBytes("SPIDR packet ID (0x50)", 8);
-        }
-        // SPIDR packet ID (0x50)
-        uint64_t packet_count;
-        if (decode_spidr_packet_id(word, packet_count)) {
-            // Packet count tracking
-        }
-        return;
-    }
-    
-    if (full_type == TPX3_CONTROL) {
-        if (enable_accounting) {
-            processor.addPacketBytes("TPX3 control (0x71)", 8);
-        }
-        // TPX3 control (0x71)
-        Tpx3ControlCmd cmd;
-        if (decode_tpx3_control(word, cmd)) {
-            // Control command decoded
-        }
-        return;
-    }
-    
-    if (full_type == EXTRA_TIMESTAMP || full_type == EXTRA_TIMESTAMP_MPX3) {
-        if (enable_accounting) {
-            processor.addPacketBytes(format_type_label("Extra timestamp", full_type), 8);
-        }
-        // Extra timestamp packets - handled separately in main processing loop
-        return;
-    }
-    
-    if (full_type == GLOBAL_TIME_LOW || full_type == GLOBAL_TIME_HIGH) {
-        if (enable_accounting) {
-            processor.addPacketBytes(format_type_label("Global time", full_type), 8);
-        }
-        // GlobalTime gt = decode_global_time(word);
-        // Future: Use for time extension
-        return;
-    }
-    
-    // For other packets, use 4-bit type
-    uint8_t packet_type = (word >> 60) & 0xF;
-    if (enable_accounting) {
-        processor.incrementPacketType(packet_type);
-    }
-    
-    switch (packet_type) {
-        case PIXEL_COUNT_FB:
-        case PIXEL_STANDARD: {
-            if (enable_accounting) {
-                if (packet_type == PIXEL_COUNT_FB) {
-                    processor.addPacketBytes("Pixel count_fb (0x0a)", 8);
-                } else {
-                    processor.addPacketBytes("Pixel standard (0x0b)", 8);
-                }
-            }
-            try {
-                PixelHit hit = decode_pixel_data(word, chip_index);
-                
-                // Apply timestamp extension if we have chunk metadata
-                if (chunk_meta.has_extra_packets) {
-                    // Extract 30-bit timestamp
-                    uint64_t truncated_toa = hit.toa_ns & 0x3FFFFFFF;
-                    hit.toa_ns = extend_timestamp(truncated_toa, chunk_meta.min_timestamp_ns, 30);
-                }
-                
-                processor.addHit(hit);
-            } catch (const std::exception& e) {
-                processor.incrementDecodeError();
-                // Only print first few errors to avoid flooding output
-                static int pixel_error_count = 0;
-                if (pixel_error_count++ < 5) {
-                    std::cerr << "Error decoding pixel data: " << e.what() << std::endl;
-                }
-            }
-            break;
-        }
-        
-        case TDC_DATA: {
-            if (enable_accounting) {
-                processor.addPacketBytes("TDC data (0x06)", 8);
-            }
-            try {
-                TDCEvent tdc = decode_tdc_data(word);
-                processor.addTdcEvent(tdc, chip_index);
-            } catch (const std::exception& e) {
-                processor.incrementDecodeError();
-                // Check if this is a fractional error
-                std::string error_msg = e.what();
-                if (error_msg.find("fractional") != std::string::npos) {
-                    processor.incrementFractionalError();
-                }
-                // Only print first few errors to avoid flooding output
-                static int tdc_error_count = 0;
-                if (tdc_error_count++ < 5) {
-                    std::cerr << "Error decoding TDC data: " << error_msg << std::endl;
-                }
-            }
-            break;
-        }
-        
-        case SPIDR_CONTROL: {
-            if (enable_accounting) {
-                processor.addPacketBytes("SPIDR control (0x05)", 8);
-            }
-            SpidrControl ctrl;
-            if (decode_spidr_control(word, ctrl)) {
-                processor.incrementChunkCount();
-            }
-            break;
-        }
-        
-        default: {
-            if (enable_accounting) {
-                std::ostringstream label;
-                label << "Unknown packet type (0x" << std::hex << std::uppercase
-                      << static_cast<int>(packet_type) << ")";
-                processor.addPacketBytes(label.str(), 8);
-                processor.incrementUnknownPacket();
-            }
-            break;
-        }
-    }
-}
-
-// Flush batch buffer to dispatcher or process directly
-static void flushBatch(StreamState& state, HitProcessor& processor, DecodeDispatcher* dispatcher, bool enable_accounting) {
-    if (state.batch_buffer.empty()) return;
-    
-    if (dispatcher) {
-        dispatcher->submitBatch(state.batch_buffer, state.chip_index, state.chunk_meta);
-    } else {
-        for (uint64_t word : state.batch_buffer) {
-            process_packet(word, state.chip_index, processor, state.chunk_meta, enable_accounting);
-        }
-    }
-    state.batch_buffer.clear();
-}
-
-// Process raw data buffer
-void process_raw_data(const uint8_t* buffer, size_t bytes, HitProcessor& processor, StreamState& state,
-                      DecodeDispatcher* dispatcher, PacketReorderBuffer* reorder_buffer = nullptr,
-                      bool enable_accounting = true) {
-    const uint64_t* data_words = reinterpret_cast<const uint64_t*>(buffer);
-    size_t num_words = bytes / 8;
-    constexpr size_t BATCH_SIZE = 128;  // Batch size for dispatcher submissions
-    
-    for (size_t i = 0; i < num_words; ++i) {
-        uint64_t word = data_words[i];
-        
-        // Fast inline chunk header check (avoid struct creation on hot path)
-        // TPX3_MAGIC is 0x33585054 ('TPX3' in little-endian)
-        if ((word & 0xFFFFFFFFULL) == TPX3_MAGIC) {
-            // Flush any pending batch before starting new chunk
-            flushBatch(state, processor, dispatcher, enable_accounting);
-            
-            // Found chunk header - inline field access to avoid struct creation
-            if (enable_accounting) {
-                processor.addPacketBytes("Chunk header", 8);
-            }
-            state.saw_first_chunk_header = true;
-            // Note: chunk size includes the header word itself
-            // So we set chunk_words_remaining to chunkSize/8, which includes header
-            // We then continue to skip the header, so we process (chunkSize/8 - 1) data words
-            state.in_chunk = true;
-            // Inline field access: chunkSize() = (word >> 48) & 0xFFFF, chipIndex() = (word >> 32) & 0xFF
-            state.chunk_words_remaining = ((word >> 48) & 0xFFFF) / 8;
-            state.chip_index = (word >> 32) & 0xFF;
-            
-            // Use local counter to avoid mutex lock on getStatistics()
-            // This eliminates the expensive getStatistics() call that acquires a mutex
-            state.local_chunk_count++;
-            state.current_chunk_id = state.local_chunk_count;
-            state.pending_chunk_updates++;
-            
-            // Batch update chunk count to reduce mutex contention (update every 100 chunks)
-            // In performance mode, batch updates significantly reduce lock contention
-            // Instead of 100 mutex locks, we use 1 mutex lock per 100 chunks
-            constexpr uint64_t CHUNK_UPDATE_BATCH = 100;
-            if (state.pending_chunk_updates >= CHUNK_UPDATE_BATCH) {
-                // Batch update: increment by pending count in a single mutex lock
-                processor.incrementChunkCountBatch(state.pending_chunk_updates);
-                state.pending_chunk_updates = 0;
-            }
-            
-            // If we have a reorder buffer, reset it for new chunk
-            if (reorder_buffer) {
-                reorder_buffer->resetForNewChunk(state.current_chunk_id);
-            }
-            
-            // Reset chunk metadata
-            state.chunk_meta = {};
-            state.extra_timestamps.clear();
-            
-            continue;
-        }
-        
-        if (!state.in_chunk || state.chunk_words_remaining == 0) {
-            if (!state.saw_first_chunk_header && !state.mid_stream_flagged) {
-                processor.markMidStreamStart();
-                state.mid_stream_flagged = true;
-            }
-            if (enable_accounting) {
-                processor.addPacketBytes("Unassigned (outside chunk)", 8);
-            }
-            continue;
-        }
-        
-        state.chunk_words_remaining--;
-        
-        // Fast path: Check packet type byte first (most words are pixel data)
-        uint8_t full_type = (word >> 56) & 0xFF;
-        
-        // Check if we're near the end of chunk (last 3 words are extra timestamps)
-        bool is_near_end = (state.chunk_words_remaining <= 3);
-        
-        if (is_near_end && (full_type == EXTRA_TIMESTAMP || full_type == EXTRA_TIMESTAMP_MPX3)) {
-            // Flush batch before processing extra timestamp (chunk_meta may change)
-            flushBatch(state, processor, dispatcher, enable_accounting);
-            
-            // Extra timestamp packet (rare - only at end of chunk)
-            uint8_t extra_type = static_cast<uint8_t>(full_type);
-            if (enable_accounting) {
-                processor.addPacketBytes(format_type_label("Extra timestamp", extra_type), 8);
-            }
-            ExtraTimestamp extra_ts = decode_extra_timestamp(word);
-            state.extra_timestamps.push_back(extra_ts);
-            
-            // When we have all 3 extra packets, process them
-            if (state.extra_timestamps.size() == 3) {
-                state.chunk_meta.has_extra_packets = true;
-                state.chunk_meta.packet_gen_time_ns = state.extra_timestamps[0].timestamp_ns;
-                state.chunk_meta.min_timestamp_ns = state.extra_timestamps[1].timestamp_ns;
-                state.chunk_meta.max_timestamp_ns = state.extra_timestamps[2].timestamp_ns;
-                
-                processor.processChunkMetadata(state.chunk_meta);
-            }
-        } else if (full_type == SPIDR_PACKET_ID && reorder_buffer) {
-            // Flush batch before processing SPIDR packet ID (needs reordering)
-            flushBatch(state, processor, dispatcher, enable_accounting);
-            
-            // SPIDR packet ID packet (needs reordering) - decode and reorder
-            uint64_t packet_count = 0;
-            if (decode_spidr_packet_id(word, packet_count)) {
-                reorder_buffer->processPacket(word, packet_count, state.current_chunk_id,
-                    [&processor, &state, dispatcher, enable_accounting](uint64_t w, uint64_t /*id*/, uint64_t /*chunk*/) {
-                        // Callback: process reordered packet
-                        if (dispatcher) {
-                            dispatcher->submit(w, state.chip_index, state.chunk_meta);
-                        } else {
-                            process_packet(w, state.chip_index, processor, state.chunk_meta, enable_accounting);
-                        }
-                    });
-            } else {
-                // Decode failed, submit directly
-                if (dispatcher) {
-                    dispatcher->submit(word, state.chip_index, state.chunk_meta);
-                } else {
-                    process_packet(word, state.chip_index, processor, state.chunk_meta, enable_accounting);
-                }
-            }
-        } else {
-            // Fast path: Regular packet (most common case - pixel data, TDC, control, etc.)
-            // Collect in batch buffer to reduce mutex contention
-            state.batch_buffer.push_back(word);
-            
-            // Flush batch when it reaches BATCH_SIZE
-            if (state.batch_buffer.size() >= BATCH_SIZE) {
-                flushBatch(state, processor, dispatcher, enable_accounting);
-            }
-        }
-        
-        if (state.chunk_words_remaining == 0) {
-            // Flush batch at chunk boundary
-            flushBatch(state, processor, dispatcher, enable_accounting);
-            state.in_chunk = false;
-        }
-    }
-    
-    // Flush any remaining batch at end of buffer
-    flushBatch(state, processor, dispatcher, enable_accounting);
-    
-    // Flush pending chunk count updates
-    if (state.pending_chunk_updates > 0) {
-        processor.incrementChunkCountBatch(state.pending_chunk_updates);
-        state.pending_chunk_updates = 0;
-    }
-    
-    if (reorder_buffer) {
-        const auto& reorder_stats = reorder_buffer->getStatistics();
-        processor.updateReorderStats(
-            reorder_stats.packets_reordered,
-            reorder_stats.max_reorder_distance,
-            reorder_stats.buffer_overflows,
-            reorder_stats.packets_dropped_too_old);
-    }
-}
 
 void print_statistics(const HitProcessor& processor) {
     const Statistics& stats = processor.getStatistics();
@@ -869,6 +142,11 @@ void print_statistics(const HitProcessor& processor) {
         // Note: Per-chip rates sum may not equal detector-wide rate if different chips
         // have different activity periods. Detector-wide cumulative rate matches SERVAL.
     }
+    if (stats.chip_index_out_of_range > 0) {
+        std::cout << "⚠ " << stats.chip_index_out_of_range
+                  << " hits/TDC events had chip index >= " << stats.chip_hit_rates_hz.size()
+                  << " (excluded from per-chip stats; increase --chip-count)" << std::endl;
+    }
     
     if (!stats.packet_byte_totals.empty()) {
         std::cout << "\n=== Packet Accounting ===" << std::endl;
@@ -893,6 +171,174 @@ void print_statistics(const HitProcessor& processor) {
     }
 }
 
+void print_merge_statistics(const TimeOrderedMerger& merger) {
+    TimeOrderedMerger::Statistics stats = merger.getStatistics();
+    std::cout << "\n=== Time-Ordered Merge ===" << std::endl;
+    std::cout << "Runs received: " << stats.runs_received << std::endl;
+    std::cout << "Hits received: " << stats.hits_received << std::endl;
+    std::cout << "Hits emitted (time-ordered): " << stats.hits_emitted
+              << " in " << stats.batches_emitted << " batches" << std::endl;
+    std::cout << "Late hits (behind released output): " << stats.late_hits << std::endl;
+    std::cout << "Hits released early (memory bound): " << stats.forced_hits << std::endl;
+    std::cout << "Max buffered hits: " << stats.max_buffered_hits
+              << " (max pending runs: " << stats.max_pending_runs << ")" << std::endl;
+}
+
+void print_latency_statistics(const PipelineLatency& latency, const DecodeDispatcher* dispatcher,
+                              bool tcp_mode) {
+    std::cout << "\n=== Pipeline Latency ===" << std::endl;
+    if (tcp_mode) {
+        print_latency_line("recv->enqueue", latency.recv_to_enqueue.snapshot());
+        print_latency_line("queue wait", latency.queue_wait.snapshot());
+    }
+    print_latency_line("process buffer", latency.process_buffer.snapshot());
+    if (dispatcher) {
+        print_latency_line("decoder task", dispatcher->collectTaskLatency());
+    }
+}
+
+void print_socket_statistics(const TCPServer::ConnectionStats& conn, const TCPServer::SocketInfo& info,
+                             const TCPServer::KernelNetStats& net) {
+    std::cout << "\n=== Kernel Socket Statistics ===" << std::endl;
+    std::cout << "SO_RCVBUF: requested " << conn.rcvbuf_requested << " bytes, effective "
+              << conn.rcvbuf_effective << " bytes (kernel-reported, includes overhead)" << std::endl;
+    if (info.valid) {
+        std::cout << "TCP_INFO (last connection): rcv_space=" << info.rcv_space
+                  << " rcv_ssthresh=" << info.rcv_ssthresh
+                  << " rtt=" << info.rtt_us << "us rttvar=" << info.rttvar_us
+                  << "us rcv_rtt=" << info.rcv_rtt_us << "us retransmits=" << info.total_retrans
+                  << " lost=" << info.lost << std::endl;
+    }
+    if (!net.available) {
+        std::cout << "TcpExt counters: unavailable (/proc/net/netstat)" << std::endl;
+        return;
+    }
+    std::cout << "TcpExt since start (system-wide): PruneCalled=" << net.prune_called
+              << " RcvPruned=" << net.rcv_pruned << " OfoPruned=" << net.ofo_pruned
+              << " RcvCollapsed=" << net.rcv_collapsed << " RcvQDrop=" << net.rcvq_drop
+              << " BacklogDrop=" << net.backlog_drop << std::endl;
+    std::cout << "Zero-window advertisements: " << net.to_zero_window_adv
+              << " (wanted: " << net.want_zero_window_adv << ")" << std::endl;
+    if (net.rcv_pruned > 0 || net.ofo_pruned > 0 || net.rcvq_drop > 0 || net.backlog_drop > 0) {
+        std::cout << "\n⚠️  WARNING: The kernel dropped received TCP data (receive queue over its memory budget)." << std::endl;
+        std::cout << "   This loss happens before the parser reads the socket; raise net.core.rmem_max / SO_RCVBUF." << std::endl;
+    } else if (net.to_zero_window_adv > 0) {
+        std::cout << "   Zero-window advertisements mean the parser did not drain the socket fast enough" << std::endl;
+        std::cout << "   and the sender was throttled (data is delayed, not lost, on the TCP link)." << std::endl;
+    }
+}
+
+void report_decode_mode_switch(DispatchPolicy& policy) {
+    DispatchPolicy::Switch change;
+    if (!policy.takeSwitch(change)) {
+        return;
+    }
+    std::cout << "[Decode] Switched to " << decode_mode_name(change.mode)
+              << (change.mode == DecodeMode::Parallel ? " dispatch (inline load " : " decode (projected inline load ")
+              << static_cast<int>(100.0 * change.load + 0.5) << "%, raw queue "
+              << change.queue_depth << ")" << std::endl;
+}
+
+void add_dispatcher_gauges(QueueTelemetry& telemetry, const DecodeDispatcher& dispatcher) {
+    telemetry.addGauge("pending tasks (words)", [&dispatcher]() {
+        return static_cast<uint64_t>(dispatcher.pendingTasks());
+    });
+    for (size_t i = 0; i < dispatcher.workerCount(); ++i) {
+        telemetry.addGauge("worker " + std::to_string(i) + " deque (runs)", [&dispatcher, i]() {
+            return static_cast<uint64_t>(dispatcher.workerQueueLength(i));
+        });
+    }
+}
+
+// Periodic report that never stalls the pipeline: with decoder workers the
+// statistics are requested, and the report is due once every worker has
+// published its partial statistics after its current batch.
+struct PendingReport {
+    bool pending = false;
+    uint64_t epoch = 0;
+
+    void request(DecodeDispatcher* dispatcher) {
+        pending = true;
+        epoch = dispatcher ? dispatcher->requestStatistics() : 0;
+    }
+
+    bool due(DecodeDispatcher* dispatcher) {
+        if (!pending || (dispatcher && !dispatcher->statisticsPublished(epoch))) {
+            return false;
+        }
+        pending = false;
+        return true;
+    }
+};
+
+void print_filter_statistics(const HitFilter::Statistics& stats) {
+    std::cout << "\n=== Hit Filter ===" << std::endl;
+    std::cout << "Hits in: " << stats.hits_in << std::endl;
+    std::cout << "Rejected by ROI: " << stats.roi_rejected << std::endl;
+    std::cout << "Rejected by ToT window: " << stats.tot_rejected << std::endl;
+    std::cout << "Rejected by ToF window: " << stats.tof_rejected << std::endl;
+    std::cout << "Hits passed: " << stats.hits_passed;
+    if (stats.hits_in > 0) {
+        std::cout << " (" << std::fixed << std::setprecision(2)
+                  << (100.0 * stats.hits_passed / stats.hits_in) << "%)";
+    }
+    std::cout << std::endl;
+}
+
+void print_mask_statistics(const PixelMask& mask) {
+    std::cout << "\n=== Pixel Mask ===" << std::endl;
+    std::cout << "Masked pixels: " << mask.maskedPixels() << std::endl;
+    for (size_t chip = 0; chip < 256; ++chip) {
+        PixelMask::ChipReport report = mask.chipReport(static_cast<uint8_t>(chip));
+        if (report.masked_pixels == 0 && report.windows == 0) {
+            continue;
+        }
+        std::cout << "  Chip " << chip << ": " << report.masked_hits << " hits masked, "
+                  << report.masked_pixels << " pixels masked";
+        if (mask.hotPixelDetectionEnabled()) {
+            std::cout << " (" << report.auto_masked_pixels << " auto-detected in "
+                      << report.windows << " windows, " << report.dead_pixels
+                      << " without hits in the last window)";
+        }
+        std::cout << std::endl;
+    }
+}
+
+void print_energy_statistics(const EnergySpectrum& spectrum) {
+    uint64_t calibrated = spectrum.totalHits();
+    std::cout << "\n=== Energy Calibration ===" << std::endl;
+    std::cout << "Calibrated hits: " << calibrated
+              << " (uncalibrated pixels: " << spectrum.uncalibrated_hits << ")" << std::endl;
+    if (calibrated == 0) {
+        return;
+    }
+    // Most populated bin, excluding overflow
+    size_t peak = 0;
+    for (size_t i = 1; i + 1 < spectrum.bins.size(); ++i) {
+        if (spectrum.bins[i] > spectrum.bins[peak]) {
+            peak = i;
+        }
+    }
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Spectrum peak: " << ((peak + 0.5) * spectrum.bin_width_kev) << " keV"
+              << " (overflow: " << spectrum.bins.back() << " hits)" << std::endl;
+    for (size_t chip = 0; chip < spectrum.chip_hits.size(); ++chip) {
+        uint64_t hits = spectrum.chip_hits[chip];
+        if (hits == 0) {
+            continue;
+        }
+        double energy = spectrum.chip_energy_kev[chip];
+        std::cout << "  Chip " << chip << ": " << hits << " hits, mean "
+                  << (energy / hits) << " keV";
+        if (energy > 0.0) {
+            std::cout << ", energy-weighted centroid ("
+                      << (spectrum.chip_weighted_x[chip] / energy) << ", "
+                      << (spectrum.chip_weighted_y[chip] / energy) << ")";
+        }
+        std::cout << std::endl;
+    }
+}
+
 void print_recent_hits(const HitProcessor& processor, size_t count) {
     auto hits = processor.getHits();
     size_t total = hits.size();
@@ -929,6 +375,31 @@ int main(int argc, char* argv[]) {
     size_t decoder_workers = 0;    // 0 = auto (stream=4, file=1)
     bool decoder_workers_overridden = false;
     size_t queue_size = 2000;      // Queue size for producer/consumer pipeline (default: 2000 buffers)
+    size_t batch_size = StreamState::DEFAULT_BATCH_SIZE;  // Words per dispatcher submission
+    bool adaptive_dispatch = true;  // Switch between inline decode and the workers by load
+    bool latency_histograms = false;
+    int queue_telemetry_ms = 0;  // Queue depth sampling interval (0 = disable)
+    StatsPublisher::Config publisher_config;
+    int metrics_port = 0;  // Prometheus endpoint (0 = disable)
+    std::string metrics_host = "127.0.0.1";
+    size_t queue_telemetry_history = 600;
+    ThreadPlacement placement;     // CPU pinning per pipeline role (empty = unpinned)
+    bool numa_auto = false;
+    HugePages huge_pages = HugePages::Transparent;  // Backing of the queue buffer pool
+    bool preallocate = false;      // Prefault and mlock pipeline buffers at startup
+    size_t chip_count = HitProcessor::DEFAULT_CHIP_COUNT;  // Chips tracked per-chip (all detectors)
+    bool time_order = false;       // Merge hits of all chips into one time-ordered stream
+    TimeOrderedMerger::Config merge_config;
+    std::string time_order_output_file;  // CSV of the time-ordered hits (empty = statistics only)
+    BlockStageConfig block_stages;
+    std::string energy_calibration_file;  // Per-pixel ToT-to-energy calibration (empty = disabled)
+    std::string energy_spectrum_file;     // CSV output of the energy spectrum
+    std::string time_walk_file;           // Per-chip time-walk parameters (empty = disabled)
+    std::string pixel_mask_file;          // Hot/dead pixel mask to load
+    std::string pixel_mask_out_file;      // Write the final mask (including auto-detected pixels)
+    double hot_pixel_sigma = 0.0;         // Auto hot-pixel detection threshold (0 = disabled)
+    HitFilter hit_filter;                 // ROI / ToT / ToF event filter (disabled until configured)
+    uint64_t hot_pixel_window = 1000000;  // Hits per chip per detection window
     std::string input_file;
     bool file_mode = false;
     std::filesystem::path file_path;
@@ -962,6 +433,147 @@ int main(int argc, char* argv[]) {
             decoder_workers_overridden = true;
         } else if (arg == "--queue-size" && i + 1 < argc) {
             queue_size = std::stoul(argv[++i]);
+        } else if (arg == "--batch-size" && i + 1 < argc) {
+            batch_size = std::max<size_t>(1, std::stoul(argv[++i]));
+        } else if (arg == "--dispatch-mode" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode != "auto" && mode != "parallel") {
+                std::cerr << "--dispatch-mode must be auto or parallel" << std::endl;
+                return 1;
+            }
+            adaptive_dispatch = mode == "auto";
+        } else if (arg == "--stats-jsonl" && i + 1 < argc) {
+            publisher_config.jsonl_path = argv[++i];
+        } else if (arg == "--stats-socket" && i + 1 < argc) {
+            publisher_config.unix_socket_path = argv[++i];
+        } else if (arg == "--stats-shm" && i + 1 < argc) {
+            publisher_config.shm_name = argv[++i];
+        } else if (arg == "--stats-publish-ms" && i + 1 < argc) {
+            publisher_config.interval = std::chrono::milliseconds(std::max(1, std::stoi(argv[++i])));
+        } else if (arg == "--metrics-port" && i + 1 < argc) {
+            metrics_port = std::stoi(argv[++i]);
+            if (metrics_port < 0 || metrics_port > 65535) {
+                std::cerr << "--metrics-port must be between 0 and 65535" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--metrics-host" && i + 1 < argc) {
+            metrics_host = argv[++i];
+        } else if (arg == "--latency-histograms") {
+            latency_histograms = true;
+        } else if (arg == "--queue-telemetry" && i + 1 < argc) {
+            queue_telemetry_ms = std::max(0, std::stoi(argv[++i]));
+        } else if (arg == "--queue-telemetry-history" && i + 1 < argc) {
+            queue_telemetry_history = std::max<size_t>(1, std::stoul(argv[++i]));
+        } else if ((arg == "--cpu-network" || arg == "--cpu-processing" || arg == "--cpu-workers") &&
+                   i + 1 < argc) {
+            std::vector<int>& cpus = arg == "--cpu-network" ? placement.network
+                                   : arg == "--cpu-processing" ? placement.processing
+                                   : placement.workers;
+            if (!parse_cpu_list(argv[++i], cpus)) {
+                std::cerr << arg << " expects a CPU list such as 0-3,8" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--network-fifo" && i + 1 < argc) {
+            placement.network_fifo_priority = std::stoi(argv[++i]);
+            if (placement.network_fifo_priority < 1 || placement.network_fifo_priority > 99) {
+                std::cerr << "--network-fifo must be between 1 and 99" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--numa-auto") {
+            numa_auto = true;
+        } else if (arg == "--huge-pages" && i + 1 < argc) {
+            if (!parse_huge_pages(argv[++i], huge_pages)) {
+                std::cerr << "--huge-pages must be off, thp, 2m or 1g" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--preallocate") {
+            preallocate = true;
+        } else if (arg == "--chip-count" && i + 1 < argc) {
+            chip_count = std::stoul(argv[++i]);
+            if (chip_count == 0 || chip_count > HitProcessor::MAX_CHIP_COUNT) {
+                std::cerr << "--chip-count must be between 1 and "
+                          << HitProcessor::MAX_CHIP_COUNT << std::endl;
+                return 1;
+            }
+        } else if (arg == "--time-order") {
+            time_order = true;
+        } else if (arg == "--chunk-sort" && i + 1 < argc) {
+            std::string method = argv[++i];
+            if (method == "radix") {
+                block_stages.sort_method = ChunkSortMethod::Radix;
+            } else if (method == "std") {
+                block_stages.sort_method = ChunkSortMethod::Comparison;
+            } else {
+                std::cerr << "--chunk-sort must be 'radix' or 'std'" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--time-order-lateness-us" && i + 1 < argc) {
+            // 1 us = 640 ToA ticks of 1.5625ns
+            merge_config.lateness_ticks = std::stoull(argv[++i]) * 640ULL;
+        } else if (arg == "--time-order-max-delay-ms" && i + 1 < argc) {
+            merge_config.max_delay_ticks = std::stoull(argv[++i]) * 640000ULL;
+        } else if (arg == "--time-order-max-hits" && i + 1 < argc) {
+            merge_config.max_buffered_hits = std::stoul(argv[++i]);
+        } else if (arg == "--time-order-output" && i + 1 < argc) {
+            time_order_output_file = argv[++i];
+        } else if (arg == "--energy-calibration" && i + 1 < argc) {
+            energy_calibration_file = argv[++i];
+        } else if (arg == "--energy-bin-kev" && i + 1 < argc) {
+            block_stages.energy_bin_kev = std::stod(argv[++i]);
+            if (!(block_stages.energy_bin_kev > 0.0)) {
+                std::cerr << "--energy-bin-kev must be positive" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--energy-bins" && i + 1 < argc) {
+            block_stages.energy_bins = std::max<size_t>(1, std::stoul(argv[++i]));
+        } else if (arg == "--energy-spectrum-out" && i + 1 < argc) {
+            energy_spectrum_file = argv[++i];
+        } else if (arg == "--time-walk" && i + 1 < argc) {
+            time_walk_file = argv[++i];
+        } else if (arg == "--pixel-mask" && i + 1 < argc) {
+            pixel_mask_file = argv[++i];
+        } else if (arg == "--pixel-mask-out" && i + 1 < argc) {
+            pixel_mask_out_file = argv[++i];
+        } else if (arg == "--hot-pixel-sigma" && i + 1 < argc) {
+            hot_pixel_sigma = std::stod(argv[++i]);
+            // Beyond 8 sigma the tail probability is below double precision
+            if (!(hot_pixel_sigma > 0.0 && hot_pixel_sigma <= 8.0)) {
+                std::cerr << "--hot-pixel-sigma must be in (0, 8]" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--hot-pixel-window" && i + 1 < argc) {
+            hot_pixel_window = std::max<uint64_t>(1, std::stoull(argv[++i]));
+        } else if (arg == "--roi" && i + 1 < argc) {
+            // CHIP:XMIN,YMIN,XMAX,YMAX (inclusive)
+            unsigned chip, x_min, y_min, x_max, y_max;
+            char extra;
+            if (std::sscanf(argv[++i], "%u:%u,%u,%u,%u%c", &chip, &x_min, &y_min, &x_max, &y_max, &extra) != 5 ||
+                chip > 255 || x_min > x_max || y_min > y_max || x_max > 255 || y_max > 255) {
+                std::cerr << "--roi expects CHIP:XMIN,YMIN,XMAX,YMAX within 0-255" << std::endl;
+                return 1;
+            }
+            hit_filter.addRoi(static_cast<uint8_t>(chip),
+                              HitFilter::Roi{static_cast<uint16_t>(x_min), static_cast<uint16_t>(y_min),
+                                             static_cast<uint16_t>(x_max), static_cast<uint16_t>(y_max)});
+        } else if (arg == "--tot-window" && i + 1 < argc) {
+            unsigned min_ns, max_ns;
+            char extra;
+            if (std::sscanf(argv[++i], "%u,%u%c", &min_ns, &max_ns, &extra) != 2 ||
+                min_ns > max_ns || max_ns > UINT16_MAX) {
+                std::cerr << "--tot-window expects MIN_NS,MAX_NS" << std::endl;
+                return 1;
+            }
+            hit_filter.setTotWindow(static_cast<uint16_t>(min_ns), static_cast<uint16_t>(max_ns));
+        } else if (arg == "--tof-window-us" && i + 1 < argc) {
+            double min_us, max_us;
+            char extra;
+            if (std::sscanf(argv[++i], "%lf,%lf%c", &min_us, &max_us, &extra) != 2 ||
+                min_us < 0.0 || min_us > max_us) {
+                std::cerr << "--tof-window-us expects MIN_US,MAX_US" << std::endl;
+                return 1;
+            }
+            // 1 us = 640 ToA ticks of 1.5625ns
+            hit_filter.setTofWindow(static_cast<uint64_t>(min_us * 640.0), static_cast<uint64_t>(max_us * 640.0));
         } else if (arg == "--exit-on-disconnect") {
             exit_on_disconnect = true;
         } else if (arg == "--input-file" && i + 1 < argc) {
@@ -982,9 +594,54 @@ int main(int argc, char* argv[]) {
             std::cout << "  --stats-final-only    Only print final statistics (no periodic)" << std::endl;
             std::cout << "  --stats-disable       Disable all statistics printing" << std::endl;
             std::cout << "  --recent-hit-count N  Retain N recent hits for summary (default: 10, 0=disable)" << std::endl;
+            std::cout << "Statistics export options:" << std::endl;
+            std::cout << "  --stats-jsonl FILE    Append statistics snapshots as JSON lines" << std::endl;
+            std::cout << "  --stats-socket PATH   Send snapshots as datagrams to a UNIX socket" << std::endl;
+            std::cout << "  --stats-shm NAME      Publish snapshots in a shared-memory segment (e.g. /tpx3_stats)" << std::endl;
+            std::cout << "  --stats-publish-ms N  Snapshot interval in milliseconds (default: 1000)" << std::endl;
+            std::cout << "  --metrics-port N      Serve Prometheus metrics on http://HOST:N/metrics (default: 0=disable)" << std::endl;
+            std::cout << "  --metrics-host ADDR   Metrics listen address (default: 127.0.0.1)" << std::endl;
             std::cout << "Performance options:" << std::endl;
             std::cout << "  --decoder-workers N   Number of parallel decoder workers (default: auto)" << std::endl;
             std::cout << "  --queue-size N        Queue size for producer/consumer pipeline (default: 2000)" << std::endl;
+            std::cout << "  --batch-size N        Words per decoder worker submission (default: 128)" << std::endl;
+            std::cout << "  --dispatch-mode MODE  With decoder workers: auto (default) switches between inline decode" << std::endl;
+            std::cout << "                        and the workers by measured load; parallel always uses the workers" << std::endl;
+            std::cout << "  --latency-histograms  Record per-stage pipeline latency (p50/p99/max in statistics)" << std::endl;
+            std::cout << "  --queue-telemetry MS  Sample queue depths and socket backlog every MS ms (default: 0=disable)" << std::endl;
+            std::cout << "  --queue-telemetry-history N  Samples kept for min/mean/max (default: 600)" << std::endl;
+            std::cout << "Thread placement options:" << std::endl;
+            std::cout << "  --cpu-network LIST    Pin the network (recv) thread to CPUs, e.g. 2 or 0-3,8" << std::endl;
+            std::cout << "  --cpu-processing LIST Pin the chunk framing thread (file mode: the reader)" << std::endl;
+            std::cout << "  --cpu-workers LIST    Pin decoder workers, one CPU each (worker i on the i-th CPU, wrapping)" << std::endl;
+            std::cout << "  --network-fifo PRIO   Run the network thread as SCHED_FIFO 1-99 (needs CAP_SYS_NICE)" << std::endl;
+            std::cout << "  --numa-auto           Place unset roles on the CPUs of the NIC's NUMA node" << std::endl;
+            std::cout << "  --huge-pages MODE     Queue buffer pages: off, thp (default), 2m or 1g (hugetlb, falls back to thp)" << std::endl;
+            std::cout << "  --preallocate         Prefault and mlock all queue buffers (queue-size x 1 MB) and decoder strand rings at startup" << std::endl;
+            std::cout << "Time-ordering options:" << std::endl;
+            std::cout << "  --time-order          Merge hits of all chips into a time-ordered stream" << std::endl;
+            std::cout << "  --chunk-sort METHOD   Per-chunk ToA sort: radix (default) or std" << std::endl;
+            std::cout << "  --time-order-lateness-us N  Allowed out-of-order ToA within a chip (default: 1000)" << std::endl;
+            std::cout << "  --time-order-max-delay-ms N Max data-time delay before a lagging chip is skipped (default: 500)" << std::endl;
+            std::cout << "  --time-order-max-hits N     Max hits buffered by the merge stage (default: 4000000)" << std::endl;
+            std::cout << "  --time-order-output FILE    Write the time-ordered hits as CSV (default: statistics only)" << std::endl;
+            std::cout << "Calibration options:" << std::endl;
+            std::cout << "  --energy-calibration FILE  Per-pixel ToT-to-energy calibration (lines: chip x y a b c t)" << std::endl;
+            std::cout << "  --energy-bin-kev W    Energy spectrum bin width in keV (default: 1)" << std::endl;
+            std::cout << "  --energy-bins N       Energy spectrum bins, plus one overflow bin (default: 1000)" << std::endl;
+            std::cout << "  --energy-spectrum-out FILE  Write the final energy spectrum as CSV" << std::endl;
+            std::cout << "  --time-walk FILE      Per-chip ToA time-walk correction (lines: chip a b c)" << std::endl;
+            std::cout << "Filter options:" << std::endl;
+            std::cout << "  --roi C:X0,Y0,X1,Y1   Keep hits inside this rectangle of chip C (repeatable)" << std::endl;
+            std::cout << "  --tot-window MIN,MAX  Keep hits with MIN <= ToT <= MAX ns" << std::endl;
+            std::cout << "  --tof-window-us MIN,MAX  Keep hits MIN..MAX us after the latest TDC1 rising edge" << std::endl;
+            std::cout << "Pixel mask options:" << std::endl;
+            std::cout << "  --pixel-mask FILE     Drop hits of masked pixels at decode (lines: chip x y)" << std::endl;
+            std::cout << "  --hot-pixel-sigma N   Auto-mask pixels above mean + N sigma of the chip's hit counts (0 < N <= 8)" << std::endl;
+            std::cout << "  --hot-pixel-window N  Hits per chip per hot-pixel detection window (default: 1000000)" << std::endl;
+            std::cout << "  --pixel-mask-out FILE Write the final mask, including auto-detected pixels" << std::endl;
+            std::cout << "Detector options:" << std::endl;
+            std::cout << "  --chip-count N        Number of chips across all detectors (default: 4, max: 256)" << std::endl;
             std::cout << "Other options:" << std::endl;
             std::cout << "  --exit-on-disconnect  Exit after connection closes (don't auto-reconnect)" << std::endl;
             std::cout << "  --help                Show this help message" << std::endl;
@@ -1025,9 +682,12 @@ int main(int argc, char* argv[]) {
         std::cout << "Recent hit history: retaining last " << recent_hit_count << " hits" << std::endl;
     }
     
-    HitProcessor processor;
+    std::cout << "Chip count: " << chip_count << std::endl;
+    
+    HitProcessor processor(chip_count);
     processor.setRecentHitCapacity(recent_hit_count);
     StreamState stream_state;
+    stream_state.batch_size = batch_size;
     size_t worker_count = decoder_workers;
     if (!decoder_workers_overridden) {
         if (file_mode) {
@@ -1039,9 +699,251 @@ int main(int argc, char* argv[]) {
         worker_count = file_mode ? 1 : std::max<size_t>(4, std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 4);
     }
     
+    if (!time_order_output_file.empty() && !time_order) {
+        std::cerr << "--time-order-output requires --time-order" << std::endl;
+        return 1;
+    }
+    
+    // Declared before the merger, whose batch callback writes to it
+    std::ofstream time_order_output;
+    std::unique_ptr<TimeOrderedMerger> merger;
+    std::unique_ptr<ChunkHitCollector> inline_collector;
+    if (time_order) {
+        merge_config.expected_chips = chip_count;
+        TimeOrderedMerger::BatchCallback sink;
+        if (!time_order_output_file.empty()) {
+            time_order_output.open(time_order_output_file);
+            if (!time_order_output) {
+                std::cerr << "Error: cannot write " << time_order_output_file << std::endl;
+                return 1;
+            }
+            time_order_output << "toa_ticks,chip,x,y,tot_ns,energy_kev\n";
+            // Runs serially under the merger lock
+            sink = [&time_order_output](const HitBlock& batch) {
+                for (size_t i = 0; i < batch.size(); ++i) {
+                    time_order_output << batch.toa[i] << ',' << static_cast<unsigned>(batch.chip[i]) << ','
+                                      << batch.x[i] << ',' << batch.y[i] << ',' << batch.tot[i] << ','
+                                      << batch.energy[i] << '\n';
+                }
+            };
+        }
+        merger = std::make_unique<TimeOrderedMerger>(merge_config, sink);
+        std::cout << "Time-ordered merge: enabled (lateness "
+                  << (merge_config.lateness_ticks / 640.0) << " us, max delay "
+                  << (merge_config.max_delay_ticks / 640000.0) << " ms, max "
+                  << merge_config.max_buffered_hits << " hits), output: "
+                  << (time_order_output_file.empty() ? "statistics only" : time_order_output_file) << std::endl;
+    }
+    
+    block_stages.merger = merger.get();
+    
+    std::unique_ptr<EnergyCalibration> energy_calibration;
+    if (!energy_calibration_file.empty()) {
+        energy_calibration = std::make_unique<EnergyCalibration>();
+        std::string error;
+        if (!energy_calibration->loadFromFile(energy_calibration_file, error)) {
+            std::cerr << "Error loading energy calibration: " << error << std::endl;
+            return 1;
+        }
+        block_stages.calibration = energy_calibration.get();
+        std::cout << "Energy calibration: " << energy_calibration->calibratedPixels() << " pixels on "
+                  << energy_calibration->calibratedChips() << " chip(s)";
+        if (energy_calibration->rejectedPixels() > 0) {
+            std::cout << " (" << energy_calibration->rejectedPixels() << " rejected: need a > 0, c >= 0)";
+        }
+        std::cout << std::endl;
+    }
+    
+    std::unique_ptr<TimeWalkCorrection> time_walk;
+    if (!time_walk_file.empty()) {
+        time_walk = std::make_unique<TimeWalkCorrection>();
+        std::string error;
+        if (!time_walk->loadFromFile(time_walk_file, error)) {
+            std::cerr << "Error loading time-walk parameters: " << error << std::endl;
+            return 1;
+        }
+        block_stages.time_walk = time_walk.get();
+        std::cout << "Time-walk correction: " << time_walk->correctedChips() << " chip(s)" << std::endl;
+    }
+    
+    std::unique_ptr<PixelMask> pixel_mask;
+    if (!pixel_mask_file.empty() || hot_pixel_sigma > 0.0) {
+        pixel_mask = std::make_unique<PixelMask>();
+        if (!pixel_mask_file.empty()) {
+            std::string error;
+            if (!pixel_mask->loadFromFile(pixel_mask_file, error)) {
+                std::cerr << "Error loading pixel mask: " << error << std::endl;
+                return 1;
+            }
+        }
+        if (hot_pixel_sigma > 0.0) {
+            pixel_mask->enableHotPixelDetection(hot_pixel_sigma, hot_pixel_window);
+        }
+        stream_state.decode.mask = pixel_mask.get();
+        std::cout << "Pixel mask: " << pixel_mask->maskedPixels() << " pixel(s) masked";
+        if (hot_pixel_sigma > 0.0) {
+            std::cout << ", hot-pixel detection at " << hot_pixel_sigma << " sigma per "
+                      << hot_pixel_window << " hits";
+        }
+        std::cout << std::endl;
+    }
+    
+    if (hit_filter.enabled()) {
+        block_stages.filter = &hit_filter;
+        if (hit_filter.usesTdc1()) {
+            block_stages.tdc1_history = &hit_filter.tdc1History();
+            stream_state.decode.tdc1_history = &hit_filter.tdc1History();
+        }
+        std::cout << "Hit filter: enabled" << std::endl;
+    }
+    
+    // Workers pin themselves before allocating their state; the processing and network
+    // threads pin themselves once started, after every helper thread has been spawned
+    // (threads inherit the affinity of the thread that creates them)
+    if (numa_auto) {
+        std::string interface = file_mode ? std::string() : route_interface(host, port);
+        int node = interface_numa_node(interface);
+        placement.autoPlace(node, worker_count > 1 ? worker_count : 0, !file_mode);
+        std::cout << "Automatic placement: "
+                  << (interface.empty() ? std::string() : "interface " + interface + ", ")
+                  << (node >= 0 ? "NUMA node " + std::to_string(node) : "NUMA node unknown, using allowed CPUs")
+                  << std::endl;
+    }
+    
     std::unique_ptr<DecodeDispatcher> dispatcher;
     if (worker_count > 1) {
-        dispatcher = std::make_unique<DecodeDispatcher>(worker_count, processor, recent_hit_count);
+        dispatcher = std::make_unique<DecodeDispatcher>(worker_count, processor, recent_hit_count,
+                                                        stream_state.decode, block_stages, placement.workers);
+        if (preallocate) {
+            // The workers prefaulted their home chips' rings on their own node; pin them too
+            std::string lock_error;
+            size_t locked = dispatcher->lockStrandRings(lock_error);
+            if (!lock_error.empty()) {
+                std::cerr << "Warning: decoder strand rings: " << lock_error << std::endl;
+            }
+            std::cout << "Preallocated " << (locked >> 20) << " MB of decoder strand rings" << std::endl;
+        }
+    } else if (block_stages.enabled()) {
+        inline_collector = std::make_unique<ChunkHitCollector>(block_stages);
+        stream_state.decode.collector = inline_collector.get();
+    }
+    
+    if (placement.any() || placement.network_fifo_priority > 0) {
+        auto describe = [](const std::vector<int>& cpus) {
+            return cpus.empty() ? std::string("unpinned") : "CPU " + format_cpu_list(cpus);
+        };
+        std::cout << "Thread placement:" << std::endl;
+        if (!file_mode) {
+            std::cout << "  Network:    " << describe(placement.network);
+            if (placement.network_fifo_priority > 0) {
+                std::cout << ", SCHED_FIFO " << placement.network_fifo_priority;
+            }
+            std::cout << std::endl;
+        }
+        std::cout << "  Processing: " << describe(placement.processing) << std::endl;
+        if (!dispatcher) {
+            std::cout << "  Decoding:   inline on the processing thread" << std::endl;
+        } else if (!placement.workers.empty()) {
+            std::cout << "  Workers:   ";
+            for (size_t i = 0; i < dispatcher->workerCount(); ++i) {
+                std::cout << " " << i << "->" << dispatcher->workerCpu(i);
+                if (!dispatcher->workerPlacementError(i).empty()) {
+                    std::cout << " (failed: " << dispatcher->workerPlacementError(i) << ")";
+                } else if (dispatcher->workerNumaNode(i) >= 0 && numa_node_count() > 1) {
+                    std::cout << " (node " << dispatcher->workerNumaNode(i) << ")";
+                }
+            }
+            std::cout << std::endl;
+        } else {
+            std::cout << "  Workers:    unpinned" << std::endl;
+        }
+    }
+    
+    std::unique_ptr<DispatchPolicy> dispatch_policy;
+    if (dispatcher && adaptive_dispatch) {
+        // Start inline: the rate is unknown and the first windows measure the inline cost
+        dispatch_policy = std::make_unique<DispatchPolicy>(DecodeMode::Inline);
+        stream_state.dispatch_policy = dispatch_policy.get();
+        stream_state.decode_mode = DecodeMode::Inline;
+        std::cout << "Dispatch mode: adaptive (inline decode below "
+                  << static_cast<int>(100 * DispatchPolicy::Config{}.inline_load) << "% projected load, workers above "
+                  << static_cast<int>(100 * DispatchPolicy::Config{}.parallel_load) << "%)" << std::endl;
+    }
+    
+    std::unique_ptr<PipelineLatency> latency;
+    if (latency_histograms) {
+        latency = std::make_unique<PipelineLatency>();
+        if (dispatcher) {
+            dispatcher->enableTaskLatency();
+        }
+        std::cout << "Latency histograms: enabled" << std::endl;
+    }
+    
+    if (metrics_port > 0 && queue_telemetry_ms == 0) {
+        queue_telemetry_ms = 100;  // Queue depths for the metrics endpoint
+    }
+    std::unique_ptr<QueueTelemetry> telemetry;
+    if (queue_telemetry_ms > 0) {
+        telemetry = std::make_unique<QueueTelemetry>(std::chrono::milliseconds(queue_telemetry_ms),
+                                                     queue_telemetry_history);
+        std::cout << "Queue telemetry: every " << queue_telemetry_ms << " ms, "
+                  << queue_telemetry_history << " samples" << std::endl;
+    }
+    
+    std::unique_ptr<StatsPublisher> publisher;
+    if (publisher_config.enabled()) {
+        // Snapshots ask the workers to publish their partial statistics after their current
+        // task; only the publisher thread waits for that, never for the queues to drain
+        publisher = std::make_unique<StatsPublisher>(publisher_config, [&processor, &dispatcher]() {
+            if (dispatcher) {
+                dispatcher->waitForStatistics(dispatcher->requestStatistics(), std::chrono::milliseconds(100));
+            }
+            processor.finalizeRates();
+            return processor.getStatistics();
+        });
+        std::string error;
+        if (!publisher->open(error)) {
+            std::cerr << "Statistics export: " << error << std::endl;
+            return 1;
+        }
+        publisher->start();
+        std::cout << "Statistics export: every " << publisher_config.interval.count() << " ms" << std::endl;
+    }
+    
+    std::unique_ptr<MetricsServer> metrics;
+    if (metrics_port > 0) {
+        // Scrapes run on the server thread: worker statistics via an epoch (bounded wait),
+        // queue depths from the telemetry samples, latencies from histogram snapshots
+        metrics = std::make_unique<MetricsServer>(metrics_host, static_cast<uint16_t>(metrics_port), [&]() {
+            if (dispatcher) {
+                dispatcher->waitForStatistics(dispatcher->requestStatistics(), std::chrono::milliseconds(50));
+            }
+            processor.finalizeRates();
+            PrometheusWriter writer;
+            append_statistics_metrics(writer, processor.getStatistics());
+            if (telemetry) {
+                append_queue_metrics(writer, telemetry->summarize());
+            }
+            if (latency) {
+                std::vector<std::pair<std::string, LatencyHistogram::Snapshot>> stages;
+                if (!file_mode) {
+                    stages.emplace_back("recv_to_enqueue", latency->recv_to_enqueue.snapshot());
+                    stages.emplace_back("queue_wait", latency->queue_wait.snapshot());
+                }
+                stages.emplace_back("process_buffer", latency->process_buffer.snapshot());
+                if (dispatcher) {
+                    stages.emplace_back("decoder_task", dispatcher->collectTaskLatency());
+                }
+                append_latency_metrics(writer, stages);
+            }
+            return writer.str();
+        });
+        std::string error;
+        if (!metrics->start(error)) {
+            std::cerr << "Metrics endpoint: " << error << std::endl;
+            return 1;
+        }
+        std::cout << "Metrics endpoint: http://" << metrics_host << ":" << metrics_port << "/metrics" << std::endl;
     }
     
     std::unique_ptr<PacketReorderBuffer> reorder_buffer;
@@ -1056,8 +958,12 @@ int main(int argc, char* argv[]) {
     auto first_data_time = std::chrono::steady_clock::now();
     size_t print_counter = 0;
     auto last_status_print = std::chrono::steady_clock::now();
+    PendingReport periodic_report;
+    PendingReport status_report;
     uint64_t last_hits = 0;
     TCPServer::ConnectionStats conn_stats{};
+    TCPServer::SocketInfo last_socket_info;
+    TCPServer::KernelNetStats kernel_net_stats;
     
     if (file_mode) {
         file_path = std::filesystem::absolute(std::filesystem::path(input_file));
@@ -1073,6 +979,19 @@ int main(int argc, char* argv[]) {
         std::vector<uint8_t> leftover;
         leftover.reserve(8);
         
+        if (telemetry) {
+            if (dispatcher) {
+                add_dispatcher_gauges(*telemetry, *dispatcher);
+            }
+            telemetry->start();
+        }
+        
+        // The main thread frames chunks in file mode
+        std::string placement_error;
+        if (!pin_current_thread(placement.processing, placement_error)) {
+            std::cerr << "Warning: processing thread placement: " << placement_error << std::endl;
+        }
+        
         while (input) {
             input.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
             std::streamsize read = input.gcount();
@@ -1110,11 +1029,21 @@ int main(int argc, char* argv[]) {
             
             size_t aligned = (remaining / 8) * 8;
             if (aligned > 0) {
+                auto process_start = std::chrono::steady_clock::now();
                 process_raw_data(data_ptr, aligned, processor, stream_state,
                         dispatcher ? dispatcher.get() : nullptr,
                         reorder_buffer ? reorder_buffer.get() : nullptr,
                         !stats_final_only);
+                if (latency) {
+                    latency->process_buffer.recordSince(process_start);
+                }
                 size_t words = aligned / 8;
+                if (dispatch_policy) {
+                    dispatch_policy->recordBuffer(process_start, std::chrono::steady_clock::now(), words, 0);
+                    if (!stats_disable) {
+                        report_decode_mode_switch(*dispatch_policy);
+                    }
+                }
                 total_packets_received += words;
                 words_processed_this_chunk += words;
                 data_ptr += aligned;
@@ -1127,15 +1056,18 @@ int main(int argc, char* argv[]) {
             
             if (!stats_disable && stats_interval > 0 && !stats_final_only) {
                 print_counter += words_processed_this_chunk;
-                if (print_counter >= stats_interval) {
+                if (print_counter >= stats_interval && !periodic_report.pending) {
+                    periodic_report.request(dispatcher.get());
+                    print_counter = 0;
+                }
+                if (periodic_report.due(dispatcher.get())) {
                     std::cout << "\n[Periodic Statistics Update]" << std::endl;
-                    if (dispatcher) {
-                        dispatcher->waitUntilIdle();
-                    }
                     processor.finalizeRates();
                     print_statistics(processor);
+                    if (latency) {
+                        print_latency_statistics(*latency, dispatcher.get(), false);
+                    }
                     std::cout << std::endl;
-                    print_counter = 0;
                 }
             }
             
@@ -1143,19 +1075,22 @@ int main(int argc, char* argv[]) {
                 auto now = std::chrono::steady_clock::now();
                 auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
                     now - last_status_print).count();
-                if (elapsed >= stats_time_interval) {
-                    if (dispatcher) {
-                        dispatcher->flushAll();
-                    }
-                    const Statistics& stats = processor.getStatistics();
+                if (elapsed >= stats_time_interval && !status_report.pending) {
+                    status_report.request(dispatcher.get());
+                    last_status_print = now;
+                }
+                if (status_report.due(dispatcher.get())) {
+                    Statistics stats = processor.getStatistics();
                     uint64_t hits_diff = stats.total_hits - last_hits;
                     std::cout << "[Status] Processed " << hits_diff << " hits in last "
                               << stats_time_interval << "s" << std::endl;
                     std::cout << "[Status] Total bytes processed: " << total_bytes_received
                               << " (" << (total_bytes_received / 1024.0 / 1024.0) << " MB)" << std::endl;
                     std::cout << "[Status] Total packets (words) processed: " << total_packets_received << std::endl;
+                    if (telemetry) {
+                        print_queue_telemetry(*telemetry);
+                    }
                     last_hits = stats.total_hits;
-                    last_status_print = now;
                 }
             }
         }
@@ -1174,12 +1109,53 @@ int main(int argc, char* argv[]) {
         if (dispatcher) {
             dispatcher->waitUntilIdle();
         }
+        if (telemetry) {
+            telemetry->stop();
+        }
     } else {
         // Producer/consumer pipeline: network thread pushes to queue, processing thread drains it
         RawDataQueue data_queue(queue_size);  // Configurable queue size (default: 2000 buffers)
         std::atomic<bool> processing_active{true};
         
-        std::cout << "Queue size: " << queue_size << " buffers" << std::endl;
+        // Queue buffers come from a pool on the processing thread's NUMA node (they are
+        // written by the network thread but read by the processing thread)
+        int queue_node = placement.processing.empty() ? placement.numa_node
+                                                      : numa_node_of_cpu(placement.processing.front());
+        std::string pool_error;
+        if (!data_queue.enablePool(TCPServer::RECV_BUFFER_SIZE, queue_node, huge_pages, pool_error)) {
+            std::cerr << "Warning: queue buffer pool: " << pool_error << " (using heap buffers)" << std::endl;
+        } else {
+            if (!pool_error.empty()) {
+                std::cerr << "Warning: queue buffer pool: " << pool_error << std::endl;
+            }
+            NodeMemory& pool_memory = data_queue.pool().memory();
+            if ((huge_pages == HugePages::Huge2M || huge_pages == HugePages::Huge1G) && !pool_memory.hugetlb()) {
+                std::cerr << "Warning: not enough hugetlb pages reserved (vm.nr_hugepages) for "
+                          << (pool_memory.size() >> 20) << " MB, using transparent huge pages" << std::endl;
+            } else if (huge_pages == HugePages::Huge1G && pool_memory.pageBytes() != (size_t{1} << 30)) {
+                std::cerr << "Warning: no 1 GB pages available, using 2 MB huge pages" << std::endl;
+            }
+            if (preallocate) {
+                // Every page faulted in (on the pool's node) and pinned before data arrives,
+                // so the first seconds of a run see the same memory as steady state
+                auto prefault_start = std::chrono::steady_clock::now();
+                pool_memory.prefault();
+                std::string lock_error;
+                if (!pool_memory.lock(lock_error)) {
+                    std::cerr << "Warning: queue buffer pool: " << lock_error << std::endl;
+                }
+                std::cout << "Preallocated " << (pool_memory.size() >> 20) << " MB of queue buffers in "
+                          << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 std::chrono::steady_clock::now() - prefault_start).count()
+                          << " ms" << std::endl;
+            }
+        }
+        std::cout << "Queue size: " << queue_size << " buffers";
+        if (data_queue.pool().slotCount() > 0) {
+            std::cout << " (" << data_queue.pool().slotBytes() / 1024 << " KB slots, "
+                      << data_queue.pool().memory().describe() << ")";
+        }
+        std::cout << std::endl;
         // Note: Chunk parsing is inherently sequential (chunks can span buffers),
         // so we use a single processing thread. Parallelism is achieved via DecodeDispatcher.
         
@@ -1197,6 +1173,19 @@ int main(int argc, char* argv[]) {
             std::cout << "Waiting for data (high-rate mode)...\n" << std::endl;
         }
         
+        if (telemetry) {
+            telemetry->addGauge("raw queue (buffers)", [&data_queue]() {
+                return static_cast<uint64_t>(data_queue.size());
+            }, queue_size);
+            telemetry->addGauge("socket backlog (bytes)", [&server]() {
+                return static_cast<uint64_t>(server.receiveBacklog());
+            });
+            if (dispatcher) {
+                add_dispatcher_gauges(*telemetry, *dispatcher);
+            }
+            telemetry->start();
+        }
+        
         static TCPServer* g_server = &server;
         static RawDataQueue* g_queue = &data_queue;
         static std::atomic<bool>* g_processing = &processing_active;
@@ -1233,6 +1222,10 @@ int main(int argc, char* argv[]) {
         // Chunk parsing is sequential (chunks can span buffers), so we use one thread.
         // Parallelism is achieved via DecodeDispatcher for actual decoding.
         std::thread processing_thread([&]() {
+            std::string placement_error;
+            if (!pin_current_thread(placement.processing, placement_error)) {
+                std::cerr << "Warning: processing thread placement: " << placement_error << std::endl;
+            }
             RawDataQueue::Buffer buffer;
             // Continue processing until queue is stopped AND empty
             while (true) {
@@ -1250,23 +1243,40 @@ int main(int argc, char* argv[]) {
                     
                     // Process data (no mutex needed - single thread)
                     // Disable packet accounting in performance mode (--stats-final-only)
-                    process_raw_data(buffer.data.data(), buffer.size, processor, stream_state,
+                    auto process_start = std::chrono::steady_clock::now();
+                    process_raw_data(buffer.bytes(), buffer.size, processor, stream_state,
                                     dispatcher ? dispatcher.get() : nullptr,
                                     reorder_buffer ? reorder_buffer.get() : nullptr,
                                     !stats_final_only);
+                    if (latency) {
+                        latency->queue_wait.record(static_cast<uint64_t>(
+                            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                process_start - buffer.enqueued).count()));
+                        latency->process_buffer.recordSince(process_start);
+                    }
+                    if (dispatch_policy) {
+                        dispatch_policy->recordBuffer(process_start, std::chrono::steady_clock::now(),
+                                                      buffer.size / 8, data_queue.size());
+                        if (!stats_disable) {
+                            report_decode_mode_switch(*dispatch_policy);
+                        }
+                    }
                     
                     // Handle statistics printing
                     if (!stats_disable && stats_interval > 0 && !stats_final_only) {
                         print_counter += (buffer.size / 8);
-                        if (print_counter >= stats_interval) {
+                        if (print_counter >= stats_interval && !periodic_report.pending) {
+                            periodic_report.request(dispatcher.get());
+                            print_counter = 0;
+                        }
+                        if (periodic_report.due(dispatcher.get())) {
                             std::cout << "\n[Periodic Statistics Update]" << std::endl;
-                            if (dispatcher) {
-                                dispatcher->waitUntilIdle();
-                            }
                             processor.finalizeRates();
                             print_statistics(processor);
+                            if (latency) {
+                                print_latency_statistics(*latency, dispatcher.get(), true);
+                            }
                             std::cout << std::endl;
-                            print_counter = 0;
                         }
                     }
                     
@@ -1274,19 +1284,31 @@ int main(int argc, char* argv[]) {
                         auto now = std::chrono::steady_clock::now();
                         auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
                             now - last_status_print).count();
-                        if (elapsed >= stats_time_interval) {
-                            if (dispatcher) {
-                                dispatcher->flushAll();
-                            }
-                            const Statistics& stats = processor.getStatistics();
+                        if (elapsed >= stats_time_interval && !status_report.pending) {
+                            status_report.request(dispatcher.get());
+                            last_status_print = now;
+                        }
+                        if (status_report.due(dispatcher.get())) {
+                            Statistics stats = processor.getStatistics();
                             uint64_t hits_diff = stats.total_hits - last_hits;
                             std::cout << "[Status] Processed " << hits_diff << " hits in last "
                                       << stats_time_interval << "s" << std::endl;
                             std::cout << "[Status] Total bytes received: " << total_bytes_received
                                       << " (" << (total_bytes_received / 1024.0 / 1024.0) << " MB)" << std::endl;
                             std::cout << "[Status] Total packets (words) received: " << total_packets_received << std::endl;
+                            TCPServer::SocketInfo info = server.sampleSocketInfo();
+                            TCPServer::KernelNetStats net = server.kernelNetStatsSinceStart();
+                            std::cout << "[Status] Socket: backlog=" << info.backlog_bytes
+                                      << " rcv_space=" << info.rcv_space << " rtt=" << info.rtt_us
+                                      << "us retransmits=" << info.total_retrans
+                                      << " | kernel pruned=" << net.rcv_pruned + net.ofo_pruned
+                                      << " collapsed=" << net.rcv_collapsed
+                                      << " dropped=" << net.rcvq_drop + net.backlog_drop
+                                      << " zero-window=" << net.to_zero_window_adv << std::endl;
+                            if (telemetry) {
+                                print_queue_telemetry(*telemetry);
+                            }
                             last_hits = stats.total_hits;
-                            last_status_print = now;
                         }
                     }
                 } else {
@@ -1300,11 +1322,28 @@ int main(int argc, char* argv[]) {
             }
         });
         
+        // This thread becomes the network thread; pinned last so no helper inherits its mask
+        std::string placement_error;
+        if (!pin_current_thread(placement.network, placement_error)) {
+            std::cerr << "Warning: network thread placement: " << placement_error << std::endl;
+        }
+        if (placement.network_fifo_priority > 0 &&
+            !set_current_thread_fifo(placement.network_fifo_priority, placement_error)) {
+            std::cerr << "Warning: network thread scheduling: " << placement_error << std::endl;
+        }
+        
         // Network thread: pushes data to queue (non-blocking)
         server.run([&](const uint8_t* data, size_t size) {
             // Push to queue immediately and return (non-blocking)
             // This allows the network thread to quickly return to recv()
-            data_queue.push(data, size);
+            // (the callback is entered directly after recv(), so this is recv->enqueue)
+            if (latency) {
+                auto recv_done = std::chrono::steady_clock::now();
+                data_queue.push(data, size);
+                latency->recv_to_enqueue.recordSince(recv_done);
+            } else {
+                data_queue.push(data, size);
+            }
         });
         
         // Network thread finished, signal processing thread to stop
@@ -1315,6 +1354,9 @@ int main(int argc, char* argv[]) {
         if (processing_thread.joinable()) {
             processing_thread.join();
         }
+        if (telemetry) {
+            telemetry->stop();
+        }
         
         g_server = nullptr;
         g_queue = nullptr;
@@ -1329,6 +1371,8 @@ int main(int argc, char* argv[]) {
         }
         
         conn_stats = server.getConnectionStats();
+        last_socket_info = server.lastSocketInfo();
+        kernel_net_stats = server.kernelNetStatsSinceStart();
         bytes_dropped_incomplete = conn_stats.bytes_dropped_incomplete;
         // Note: total_bytes_received is updated by the processing thread
         // conn_stats.bytes_received reflects bytes received from socket (may differ if buffers dropped)
@@ -1355,6 +1399,49 @@ int main(int argc, char* argv[]) {
         // For TCP mode a message has already been printed above.
     }
     
+    if (publisher) {
+        if (dispatcher) {
+            dispatcher->waitUntilIdle();
+        }
+        publisher->stop();  // Final snapshot after all words are decoded
+    }
+    
+    EnergySpectrum energy_spectrum;
+    HitFilter::Statistics filter_stats;
+    if (block_stages.enabled()) {
+        // Release runs of incomplete chunks and everything still held back by the watermark
+        if (dispatcher) {
+            dispatcher->waitUntilIdle();
+            dispatcher->finishChunks();
+            dispatcher->collectEnergySpectrum(energy_spectrum);
+            dispatcher->collectFilterStatistics(filter_stats);
+        } else if (inline_collector) {
+            inline_collector->finishAll();
+            energy_spectrum.merge(inline_collector->energySpectrum());
+            filter_stats.merge(inline_collector->filterStatistics());
+        }
+        if (merger) {
+            merger->flush();
+        }
+        if (time_order_output.is_open()) {
+            time_order_output.close();
+            if (!time_order_output) {
+                std::cerr << "Error writing time-ordered hits: " << time_order_output_file << std::endl;
+            }
+        }
+    }
+    if (pixel_mask && !pixel_mask_out_file.empty()) {
+        std::string error;
+        if (!pixel_mask->saveToFile(pixel_mask_out_file, error)) {
+            std::cerr << "Error writing pixel mask: " << error << std::endl;
+        }
+    }
+    if (energy_calibration && !energy_spectrum_file.empty()) {
+        if (!energy_spectrum.writeCsv(energy_spectrum_file)) {
+            std::cerr << "Error writing energy spectrum: " << energy_spectrum_file << std::endl;
+        }
+    }
+    
     std::cout << "\n" << std::string(60, '=') << std::endl;
     std::cout << "=== FINAL SUMMARY ===" << std::endl;
     std::cout << std::string(60, '=') << std::endl;
@@ -1376,6 +1463,30 @@ int main(int argc, char* argv[]) {
         }
         processor.finalizeRates();
         print_statistics(processor);
+        if (merger) {
+            print_merge_statistics(*merger);
+        }
+        if (pixel_mask) {
+            print_mask_statistics(*pixel_mask);
+        }
+        if (block_stages.filter) {
+            print_filter_statistics(filter_stats);
+        }
+        if (latency) {
+            print_latency_statistics(*latency, dispatcher.get(), !file_mode);
+        }
+        if (telemetry) {
+            print_queue_telemetry(*telemetry);
+        }
+        if (dispatcher) {
+            std::cout << "Decoder workers: " << dispatcher->workerCount() << ", chip runs stolen: "
+                      << dispatcher->stolenRuns() << ", submit stalls: " << dispatcher->submitStalls() << std::endl;
+            std::cout << "Dispatch mode: " << (dispatch_policy ? dispatch_policy->describe() : std::string("parallel"))
+                      << std::endl;
+        }
+        if (energy_calibration) {
+            print_energy_statistics(energy_spectrum);
+        }
         print_recent_hits(processor, 10);
     }
     
@@ -1388,6 +1499,7 @@ int main(int argc, char* argv[]) {
         std::cout << "Disconnections: " << conn_stats.disconnections << std::endl;
         std::cout << "Reconnect errors: " << conn_stats.reconnect_errors << std::endl;
         std::cout << "recv() errors: " << conn_stats.recv_errors << std::endl;
+        print_socket_statistics(conn_stats, last_socket_info, kernel_net_stats);
         
         if (conn_stats.bytes_dropped_incomplete > 0) {
             std::cout << "\n⚠️  WARNING: " << conn_stats.bytes_dropped_incomplete
@@ -0,0 +1,381 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "metrics_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+
+namespace {
+
+std::string escape_label_value(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+}  // namespace
+
+void PrometheusWriter::family(const std::string& name, const std::string& type, const std::string& help) {
+    out_ << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+}
+
+void PrometheusWriter::sample(const std::string& name, double value, const Labels& labels) {
+    out_ << name;
+    if (!labels.empty()) {
+        out_ << "{";
+        for (size_t i = 0; i < labels.size(); ++i) {
+            out_ << (i ? "," : "") << labels[i].first << "=\"" << escape_label_value(labels[i].second) << "\"";
+        }
+        out_ << "}";
+    }
+    if (std::isnan(value)) {
+        out_ << " NaN\n";
+    } else {
+        out_ << " " << std::setprecision(15) << value << "\n";
+    }
+}
+
+void append_statistics_metrics(PrometheusWriter& writer, const Statistics& stats) {
+    struct Counter {
+        const char* name;
+        const char* help;
+        uint64_t value;
+    };
+    const Counter counters[] = {
+        {"tpx3_hits_total", "Pixel hits decoded.", stats.total_hits},
+        {"tpx3_chunks_total", "Chunks framed.", stats.total_chunks},
+        {"tpx3_tdc1_events_total", "TDC1 events (rise and fall).", stats.total_tdc1_events},
+        {"tpx3_tdc2_events_total", "TDC2 events (rise and fall).", stats.total_tdc2_events},
+        {"tpx3_control_packets_total", "TPX3 control packets.", stats.total_control_packets},
+        {"tpx3_decode_errors_total", "Words that failed to decode.", stats.total_decode_errors},
+        {"tpx3_fractional_errors_total", "TDC words with an invalid fractional part.", stats.total_fractional_errors},
+        {"tpx3_unknown_packets_total", "Words of unknown packet type.", stats.total_unknown_packets},
+        {"tpx3_chip_index_out_of_range_total", "Hits and TDC events with a chip index beyond --chip-count.",
+         stats.chip_index_out_of_range},
+        {"tpx3_reordered_packets_total", "Packets processed out of order by the reorder buffer.",
+         stats.total_reordered_packets},
+        {"tpx3_reorder_dropped_total", "Packets dropped by the reorder buffer as too old.",
+         stats.reorder_packets_dropped_too_old},
+    };
+    for (const Counter& counter : counters) {
+        writer.family(counter.name, "counter", counter.help);
+        writer.sample(counter.name, static_cast<double>(counter.value));
+    }
+
+    writer.family("tpx3_rate_hz", "gauge", "Instant event rates (about 1 s window).");
+    writer.sample("tpx3_rate_hz", stats.hit_rate_hz, {{"event", "hit"}});
+    writer.sample("tpx3_rate_hz", stats.tdc1_rate_hz, {{"event", "tdc1"}});
+    writer.sample("tpx3_rate_hz", stats.tdc2_rate_hz, {{"event", "tdc2"}});
+    writer.family("tpx3_cumulative_rate_hz", "gauge", "Average event rates since start.");
+    writer.sample("tpx3_cumulative_rate_hz", stats.cumulative_hit_rate_hz, {{"event", "hit"}});
+    writer.sample("tpx3_cumulative_rate_hz", stats.cumulative_tdc1_rate_hz, {{"event", "tdc1"}});
+    writer.sample("tpx3_cumulative_rate_hz", stats.cumulative_tdc2_rate_hz, {{"event", "tdc2"}});
+
+    writer.family("tpx3_chip_hit_rate_hz", "gauge", "Instant hit rate per chip.");
+    for (size_t chip = 0; chip < stats.chip_hit_rates_hz.size(); ++chip) {
+        writer.sample("tpx3_chip_hit_rate_hz", stats.chip_hit_rates_hz[chip], {{"chip", std::to_string(chip)}});
+    }
+    writer.family("tpx3_chip_tdc1_events_total", "counter", "TDC1 events per chip.");
+    for (size_t chip = 0; chip < stats.chip_tdc1_counts.size(); ++chip) {
+        writer.sample("tpx3_chip_tdc1_events_total", static_cast<double>(stats.chip_tdc1_counts[chip]),
+                      {{"chip", std::to_string(chip)}});
+    }
+}
+
+void append_latency_metrics(PrometheusWriter& writer,
+                            const std::vector<std::pair<std::string, LatencyHistogram::Snapshot>>& stages) {
+    if (stages.empty()) {
+        return;
+    }
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    writer.family("tpx3_stage_latency_seconds", "summary", "Per-stage pipeline latency.");
+    for (const auto& stage : stages) {
+        const LatencyHistogram::Snapshot& snapshot = stage.second;
+        for (double q : quantiles) {
+            std::ostringstream label;
+            label << q;
+            writer.sample("tpx3_stage_latency_seconds",
+                          snapshot.count ? static_cast<double>(snapshot.percentileNs(q)) * 1e-9 : std::nan(""),
+                          {{"stage", stage.first}, {"quantile", label.str()}});
+        }
+        writer.sample("tpx3_stage_latency_seconds_sum", static_cast<double>(snapshot.sum_ns) * 1e-9,
+                      {{"stage", stage.first}});
+        writer.sample("tpx3_stage_latency_seconds_count", static_cast<double>(snapshot.count),
+                      {{"stage", stage.first}});
+    }
+    writer.family("tpx3_stage_latency_max_seconds", "gauge", "Maximum per-stage pipeline latency.");
+    for (const auto& stage : stages) {
+        writer.sample("tpx3_stage_latency_max_seconds", static_cast<double>(stage.second.max_ns) * 1e-9,
+                      {{"stage", stage.first}});
+    }
+}
+
+void append_queue_metrics(PrometheusWriter& writer, const std::vector<QueueTelemetry::Summary>& queues) {
+    if (queues.empty()) {
+        return;
+    }
+    writer.family("tpx3_queue_depth", "gauge", "Latest sampled queue depth or backlog.");
+    for (const auto& queue : queues) {
+        writer.sample("tpx3_queue_depth", static_cast<double>(queue.latest), {{"queue", queue.name}});
+    }
+    writer.family("tpx3_queue_depth_high_water", "gauge", "Highest sampled queue depth since start.");
+    for (const auto& queue : queues) {
+        writer.sample("tpx3_queue_depth_high_water", static_cast<double>(queue.high_water), {{"queue", queue.name}});
+    }
+    writer.family("tpx3_queue_capacity", "gauge", "Queue capacity, for bounded queues.");
+    for (const auto& queue : queues) {
+        if (queue.capacity > 0) {
+            writer.sample("tpx3_queue_capacity", static_cast<double>(queue.capacity), {{"queue", queue.name}});
+        }
+    }
+}
+
+MetricsServer::MetricsServer(const std::string& host, uint16_t port, RenderFn render)
+    : host_(host), port_(port), render_(std::move(render)) {
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(std::string& error) {
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port_);
+    if (inet_pton(AF_INET, host_.c_str(), &addr.sin_addr) <= 0) {
+        error = "invalid address " + host_;
+        return false;
+    }
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        error = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+    int opt = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listen_fd_, 16) < 0) {
+        error = "bind " + host_ + ":" + std::to_string(port_) + ": " + std::strerror(errno);
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        error = std::string("epoll/eventfd: ") + std::strerror(errno);
+        stop();
+        return false;
+    }
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event);
+    event.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+    thread_ = std::thread([this]() { serverLoop(); });
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (thread_.joinable()) {
+        uint64_t one = 1;
+        if (write(wake_fd_, &one, sizeof(one)) < 0) {
+            // The loop also exits on the next event
+        }
+        thread_.join();
+    }
+    for (auto& entry : connections_) {
+        close(entry.first);
+    }
+    connections_.clear();
+    for (int* fd : {&listen_fd_, &epoll_fd_, &wake_fd_}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void MetricsServer::serverLoop() {
+    epoll_event events[16];
+    while (true) {
+        int count = epoll_wait(epoll_fd_, events, 16, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        for (int i = 0; i < count; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd_) {
+                return;
+            }
+            if (fd == listen_fd_) {
+                acceptConnections();
+                continue;
+            }
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) {
+                continue;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(fd);
+            } else if (events[i].events & EPOLLOUT) {
+                if (!flushResponse(fd, it->second)) {
+                    closeConnection(fd);
+                }
+            } else if (events[i].events & EPOLLIN) {
+                handleReadable(fd, it->second);
+            }
+        }
+    }
+}
+
+void MetricsServer::acceptConnections() {
+    while (true) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;  // EAGAIN: no more pending connections
+        }
+        if (connections_.size() >= static_cast<size_t>(MAX_CONNECTIONS)) {
+            close(fd);
+            continue;
+        }
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            continue;
+        }
+        connections_[fd] = Connection();
+    }
+}
+
+void MetricsServer::handleReadable(int fd, Connection& connection) {
+    char buffer[2048];
+    bool peer_closed = false;
+    while (true) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            connection.request.append(buffer, static_cast<size_t>(n));
+            if (connection.request.size() > MAX_REQUEST_BYTES) {
+                closeConnection(fd);
+                return;
+            }
+            continue;
+        }
+        if (n == 0) {
+            peer_closed = true;  // Client may half-close after sending the request
+            break;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        if (errno != EINTR) {
+            closeConnection(fd);
+            return;
+        }
+    }
+    if (connection.request.find("\r\n\r\n") == std::string::npos &&
+        connection.request.find("\n\n") == std::string::npos) {
+        if (peer_closed) {
+            closeConnection(fd);
+        }
+        return;  // Headers incomplete
+    }
+    connection.response = buildResponse(connection.request);
+    ++requests_served_;
+    if (!flushResponse(fd, connection)) {
+        closeConnection(fd);
+        return;
+    }
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLOUT;
+    event.data.fd = fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event);
+}
+
+bool MetricsServer::flushResponse(int fd, Connection& connection) {
+    while (connection.sent < connection.response.size()) {
+        ssize_t n = send(fd, connection.response.data() + connection.sent,
+                         connection.response.size() - connection.sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            connection.sent += static_cast<size_t>(n);
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;  // Wait for EPOLLOUT
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    return false;  // Complete
+}
+
+void MetricsServer::closeConnection(int fd) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections_.erase(fd);
+}
+
+std::string MetricsServer::buildResponse(const std::string& request) {
+    std::istringstream line(request.substr(0, request.find('\n')));
+    std::string method;
+    std::string path;
+    line >> method >> path;
+    std::string status = "200 OK";
+    std::string content_type = "text/plain; version=0.0.4; charset=utf-8";
+    std::string body;
+    if (method != "GET" && method != "HEAD") {
+        status = "405 Method Not Allowed";
+        body = "Only GET is supported\n";
+    } else if (path == "/metrics") {
+        body = render_();
+    } else if (path == "/") {
+        content_type = "text/plain; charset=utf-8";
+        body = "TPX3 parser metrics: /metrics\n";
+    } else {
+        status = "404 Not Found";
+        body = "Not found\n";
+    }
+    std::ostringstream response;
+    response << "HTTP/1.0 " << status << "\r\n"
+             << "Content-Type: " << content_type << "\r\n"
+             << "Content-Length: " << body.size() << "\r\n"
+             << "Connection: close\r\n\r\n";
+    if (method != "HEAD") {
+        response << body;
+    }
+    return response.str();
+}
@@ -0,0 +1,231 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "numa_memory.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+constexpr size_t HUGE_PAGE_BYTES = 2 * 1024 * 1024;
+constexpr size_t GIGANTIC_PAGE_BYTES = 1024 * 1024 * 1024;
+constexpr int MPOL_PREFERRED_MODE = 1;  // <linux/mempolicy.h> MPOL_PREFERRED
+constexpr int MAX_NODES = 1024;
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+size_t round_up(size_t value, size_t multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+int page_shift(size_t page_bytes) {
+    int shift = 0;
+    while ((size_t{1} << shift) < page_bytes) {
+        ++shift;
+    }
+    return shift;
+}
+
+}  // namespace
+
+int current_numa_node() {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return -1;
+    }
+    return static_cast<int>(node);
+}
+
+bool parse_huge_pages(const std::string& text, HugePages& mode) {
+    if (text == "off") {
+        mode = HugePages::Off;
+    } else if (text == "thp") {
+        mode = HugePages::Transparent;
+    } else if (text == "2m") {
+        mode = HugePages::Huge2M;
+    } else if (text == "1g") {
+        mode = HugePages::Huge1G;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool lock_memory(const void* data, size_t bytes, std::string& error) {
+    if (mlock(data, bytes) != 0) {
+        error = "mlock(" + std::to_string(bytes >> 20) + " MB): " + std::strerror(errno) +
+                " (raise RLIMIT_MEMLOCK, e.g. ulimit -l unlimited)";
+        return false;
+    }
+    return true;
+}
+
+void unlock_memory(const void* data, size_t bytes) {
+    munlock(data, bytes);
+}
+
+bool NodeMemory::allocate(size_t bytes, int node, HugePages pages, std::string& error) {
+    release();
+    bytes = bytes == 0 ? 1 : bytes;
+
+    // Explicit huge pages, largest requested size first; reserved at mmap time,
+    // so an empty hugetlb pool fails here rather than with SIGBUS on first touch
+    std::vector<size_t> hugetlb_sizes;
+    if (pages == HugePages::Huge1G) {
+        hugetlb_sizes = {GIGANTIC_PAGE_BYTES, HUGE_PAGE_BYTES};
+    } else if (pages == HugePages::Huge2M) {
+        hugetlb_sizes = {HUGE_PAGE_BYTES};
+    }
+    for (size_t page : hugetlb_sizes) {
+        size_t length = round_up(bytes, page);
+        void* region = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (page_shift(page) << MAP_HUGE_SHIFT),
+                            -1, 0);
+        if (region != MAP_FAILED) {
+            data_ = static_cast<uint8_t*>(region);
+            bytes_ = length;
+            page_bytes_ = page;
+            hugetlb_ = true;
+            break;
+        }
+    }
+
+    if (!data_) {
+        bool transparent = pages != HugePages::Off;
+        size_t alignment = transparent ? HUGE_PAGE_BYTES : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t length = round_up(bytes, alignment);
+        // Over-map by one alignment unit so huge-page ranges start on a 2 MB boundary
+        size_t mapped = transparent ? length + alignment : length;
+        void* region = mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (region == MAP_FAILED) {
+            error = "mmap(" + std::to_string(mapped) + " bytes): " + std::strerror(errno);
+            return false;
+        }
+        uint8_t* start = static_cast<uint8_t*>(region);
+        if (transparent) {
+            uint8_t* aligned = reinterpret_cast<uint8_t*>(
+                round_up(reinterpret_cast<uintptr_t>(start), alignment));
+            if (aligned > start) {
+                munmap(start, aligned - start);
+            }
+            size_t tail = (start + mapped) - (aligned + length);
+            if (tail > 0) {
+                munmap(aligned + length, tail);
+            }
+            start = aligned;
+            huge_advised_ = madvise(start, length, MADV_HUGEPAGE) == 0;
+        }
+        data_ = start;
+        bytes_ = length;
+        page_bytes_ = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+    node_ = node;
+
+    if (node >= 0 && node < MAX_NODES) {
+        // Preferred rather than strict binding: a full node falls back instead of failing
+        unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))] = {};
+        mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+        node_bound_ = syscall(SYS_mbind, data_, bytes_, MPOL_PREFERRED_MODE, mask, MAX_NODES + 1, 0) == 0;
+        if (!node_bound_) {
+            error = "mbind(node " + std::to_string(node) + "): " + std::strerror(errno);
+        }
+    }
+    return true;
+}
+
+void NodeMemory::release() {
+    if (data_) {
+        if (locked_) {
+            munlock(data_, bytes_);
+        }
+        munmap(data_, bytes_);
+    }
+    data_ = nullptr;
+    bytes_ = 0;
+    page_bytes_ = 0;
+    node_ = -1;
+    node_bound_ = false;
+    hugetlb_ = false;
+    huge_advised_ = false;
+    prefaulted_ = false;
+    locked_ = false;
+}
+
+void NodeMemory::prefault() {
+    // A write per page: reads would only map the shared zero page
+    volatile uint8_t* bytes = data_;
+    for (size_t offset = 0; offset < bytes_; offset += page_bytes_) {
+        bytes[offset] = 0;
+    }
+    prefaulted_ = data_ != nullptr;
+}
+
+bool NodeMemory::lock(std::string& error) {
+    if (!data_ || locked_) {
+        return locked_;
+    }
+    if (!lock_memory(data_, bytes_, error)) {
+        return false;
+    }
+    locked_ = true;
+    prefaulted_ = true;  // mlock faults every page in
+    return true;
+}
+
+std::string NodeMemory::describe() const {
+    std::string text = node_bound_ ? "NUMA node " + std::to_string(node_) : std::string("first-touch placement");
+    if (hugetlb_) {
+        text += page_bytes_ == GIGANTIC_PAGE_BYTES ? ", 1 GB huge pages" : ", 2 MB huge pages";
+    } else if (huge_advised_) {
+        text += ", transparent huge pages";
+    }
+    if (locked_) {
+        text += ", locked";
+    } else if (prefaulted_) {
+        text += ", prefaulted";
+    }
+    return text;
+}
+
+bool BufferPool::allocate(size_t slot_bytes, size_t slot_count, int node, HugePages pages,
+                          std::string& error) {
+    // Cache-line aligned slots
+    slot_bytes_ = round_up(slot_bytes, 64);
+    slot_count_ = slot_count;
+    free_.clear();
+    if (!memory_.allocate(slot_bytes_ * slot_count_, node, pages, error)) {
+        slot_count_ = 0;
+        return false;
+    }
+    free_.reserve(slot_count_);
+    for (size_t i = slot_count_; i > 0; --i) {
+        free_.push_back(memory_.data() + (i - 1) * slot_bytes_);
+    }
+    return true;
+}
+
+uint8_t* BufferPool::acquire() {
+    if (free_.empty()) {
+        return nullptr;
+    }
+    uint8_t* slot = free_.back();
+    free_.pop_back();
+    return slot;
+}
+
+void BufferPool::release(uint8_t* slot) {
+    free_.push_back(slot);
+}
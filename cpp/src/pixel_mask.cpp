@@ -0,0 +1,186 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "pixel_mask.h"
+#include "tpx3_decoder.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+// Largest count still consistent with a Poisson mean at the one-sided tail
+// probability of `sigma` Gaussian standard deviations
+double poisson_cut(double mean, double sigma) {
+    double tail = 0.5 * std::erfc(sigma / std::sqrt(2.0));
+    if (mean <= 0.0) {
+        return 0.0;
+    }
+    if (mean > 500.0) {
+        return mean + sigma * std::sqrt(mean);  // exp(-mean) underflows; normal limit
+    }
+    // Above about 8 sigma the tail is below double precision and 1 - cdf
+    // stops shrinking: end there, or at a bound well past the quantile
+    double limit = mean + sigma * std::sqrt(mean) + sigma * sigma;
+    double pmf = std::exp(-mean);
+    double cdf = pmf;
+    double k = 0.0;
+    while (1.0 - cdf > tail && k < limit) {
+        k += 1.0;
+        pmf *= mean / k;
+        double next = cdf + pmf;
+        if (next == cdf) {
+            break;
+        }
+        cdf = next;
+    }
+    return k;
+}
+
+}  // namespace
+
+PixelMask::PixelMask()
+    : chips_(256), detect_(false), sigma_(5.0), window_hits_(1000000) {
+}
+
+bool PixelMask::loadFromFile(const std::string& path, std::string& error) {
+    std::ifstream input(path);
+    if (!input) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(input, line)) {
+        ++line_number;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream fields(line);
+        unsigned chip, x, y;
+        if (!(fields >> chip)) {
+            continue;  // Blank or comment line
+        }
+        if (!(fields >> x >> y) || chip > 255 || x > 255 || y > 255) {
+            error = path + ":" + std::to_string(line_number) + ": expected 'chip x y'";
+            return false;
+        }
+        maskPixel(static_cast<uint8_t>(chip), static_cast<uint16_t>(x), static_cast<uint16_t>(y));
+    }
+    return true;
+}
+
+bool PixelMask::saveToFile(const std::string& path, std::string& error) const {
+    std::ofstream output(path);
+    if (!output) {
+        error = "cannot open " + path;
+        return false;
+    }
+    output << "# chip x y\n";
+    for (size_t chip = 0; chip < chips_.size(); ++chip) {
+        const ChipState& state = chips_[chip];
+        if (state.bits.empty()) {
+            continue;
+        }
+        for (size_t addr = 0; addr < PIXELS_PER_CHIP; ++addr) {
+            if (testBit(state, addr)) {
+                uint16_t x, y;
+                std::tie(x, y) = pixaddr_to_xy(addr);
+                output << chip << " " << x << " " << y << "\n";
+            }
+        }
+    }
+    if (!output) {
+        error = "write failed: " + path;
+        return false;
+    }
+    return true;
+}
+
+void PixelMask::maskPixel(uint8_t chip, uint16_t x, uint16_t y) {
+    setBit(chips_[chip], xyToPixaddr(x, y));
+}
+
+bool PixelMask::isMasked(uint8_t chip, uint16_t x, uint16_t y) const {
+    return testBit(chips_[chip], xyToPixaddr(x, y));
+}
+
+void PixelMask::enableHotPixelDetection(double sigma, uint64_t window_hits) {
+    detect_ = true;
+    sigma_ = sigma;
+    window_hits_ = std::max<uint64_t>(1, window_hits);
+}
+
+size_t PixelMask::maskedPixels() const {
+    size_t total = 0;
+    for (const auto& state : chips_) {
+        total += state.report.masked_pixels;
+    }
+    return total;
+}
+
+void PixelMask::setBit(ChipState& state, uint16_t addr) {
+    if (state.bits.empty()) {
+        state.bits.assign(PIXELS_PER_CHIP / 64, 0);
+    }
+    uint64_t bit = 1ULL << (addr & 63);
+    if (!(state.bits[addr >> 6] & bit)) {
+        state.bits[addr >> 6] |= bit;
+        state.report.masked_pixels++;
+    }
+}
+
+void PixelMask::evaluateWindow(ChipState& state) {
+    // Sigma-clipped mean/std of per-pixel counts over unmasked pixels, so a
+    // few very hot pixels do not inflate the threshold. At low counts per
+    // pixel the Poisson tail is much heavier than the Gaussian one, so the
+    // cut is never below the Poisson quantile of the same tail probability.
+    double cut = std::numeric_limits<double>::max();
+    for (int iteration = 0; iteration < 3; ++iteration) {
+        double sum = 0.0;
+        double sum_sq = 0.0;
+        size_t n = 0;
+        for (size_t addr = 0; addr < PIXELS_PER_CHIP; ++addr) {
+            double count = state.counts[addr];
+            if (count > cut || testBit(state, addr)) {
+                continue;
+            }
+            sum += count;
+            sum_sq += count * count;
+            n++;
+        }
+        if (n == 0) {
+            break;
+        }
+        double mean = sum / n;
+        double variance = std::max(0.0, sum_sq / n - mean * mean);
+        double next_cut = std::max(mean + sigma_ * std::sqrt(variance), poisson_cut(mean, sigma_));
+        if (next_cut == cut) {
+            break;
+        }
+        cut = next_cut;
+    }
+
+    uint32_t dead = 0;
+    for (size_t addr = 0; addr < PIXELS_PER_CHIP; ++addr) {
+        uint32_t count = state.counts[addr];
+        if (count > cut) {
+            setBit(state, static_cast<uint16_t>(addr));
+            state.report.auto_masked_pixels++;
+        } else if (count == 0 && !testBit(state, addr)) {
+            dead++;
+        }
+    }
+    state.report.dead_pixels = dead;
+    state.report.windows++;
+    std::fill(state.counts.begin(), state.counts.end(), 0);
+    state.window_count = 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "queue_telemetry.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+QueueTelemetry::QueueTelemetry(std::chrono::milliseconds interval, size_t history)
+    : interval_(std::max(interval, std::chrono::milliseconds(1))),
+      history_(std::max<size_t>(history, 1)),
+      start_time_(std::chrono::steady_clock::now()) {
+}
+
+QueueTelemetry::~QueueTelemetry() {
+    stop();
+}
+
+void QueueTelemetry::addGauge(const std::string& name, Gauge gauge, uint64_t capacity) {
+    Series series;
+    series.name = name;
+    series.gauge = std::move(gauge);
+    series.capacity = capacity;
+    series.ring.assign(history_, 0);
+    std::lock_guard<std::mutex> lock(mutex_);
+    series_.push_back(std::move(series));
+}
+
+void QueueTelemetry::start() {
+    if (sampler_.joinable()) {
+        return;
+    }
+    start_time_ = std::chrono::steady_clock::now();
+    stop_requested_ = false;
+    sampler_ = std::thread([this]() { samplerLoop(); });
+}
+
+void QueueTelemetry::stop() {
+    if (!sampler_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        stop_requested_ = true;
+    }
+    stop_cv_.notify_all();
+    sampler_.join();
+    sampleAll();
+}
+
+void QueueTelemetry::samplerLoop() {
+    std::unique_lock<std::mutex> lock(stop_mutex_);
+    while (!stop_requested_) {
+        lock.unlock();
+        sampleAll();
+        lock.lock();
+        stop_cv_.wait_for(lock, interval_, [this]() { return stop_requested_; });
+    }
+}
+
+void QueueTelemetry::sampleAll() {
+    // Read the gauges outside the ring lock; they may take their own locks
+    std::vector<uint64_t> values(series_.size());
+    for (size_t i = 0; i < series_.size(); ++i) {
+        values[i] = series_[i].gauge();
+    }
+    double at_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < series_.size(); ++i) {
+        Series& series = series_[i];
+        series.ring[series.next] = values[i];
+        series.next = (series.next + 1) % series.ring.size();
+        series.filled = std::min(series.filled + 1, series.ring.size());
+        if (values[i] > series.high_water) {
+            series.high_water = values[i];
+            series.high_water_at_s = at_s;
+        }
+    }
+}
+
+std::vector<QueueTelemetry::Summary> QueueTelemetry::summarize() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Summary> summaries;
+    summaries.reserve(series_.size());
+    for (const Series& series : series_) {
+        Summary summary;
+        summary.name = series.name;
+        summary.capacity = series.capacity;
+        summary.samples = series.filled;
+        summary.high_water = series.high_water;
+        summary.high_water_at_s = series.high_water_at_s;
+        if (series.filled > 0) {
+            size_t size = series.ring.size();
+            size_t first = (series.next + size - series.filled) % size;
+            summary.min = series.ring[first];
+            uint64_t sum = 0;
+            for (size_t k = 0; k < series.filled; ++k) {
+                uint64_t value = series.ring[(first + k) % size];
+                summary.min = std::min(summary.min, value);
+                summary.max = std::max(summary.max, value);
+                sum += value;
+            }
+            summary.mean = static_cast<double>(sum) / static_cast<double>(series.filled);
+            summary.latest = series.ring[(series.next + size - 1) % size];
+        }
+        summaries.push_back(summary);
+    }
+    return summaries;
+}
+
+std::vector<uint64_t> QueueTelemetry::history(size_t gauge_index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<uint64_t> values;
+    if (gauge_index >= series_.size()) {
+        return values;
+    }
+    const Series& series = series_[gauge_index];
+    size_t size = series.ring.size();
+    size_t first = (series.next + size - series.filled) % size;
+    values.reserve(series.filled);
+    for (size_t k = 0; k < series.filled; ++k) {
+        values.push_back(series.ring[(first + k) % size]);
+    }
+    return values;
+}
+
+void print_queue_telemetry(const QueueTelemetry& telemetry) {
+    std::vector<QueueTelemetry::Summary> summaries = telemetry.summarize();
+    size_t window = summaries.empty() ? 0 : summaries.front().samples;
+    std::cout << "\n=== Queue Telemetry ===" << std::endl;
+    std::cout << "Sampled every " << telemetry.interval().count() << " ms, window of last "
+              << window << " samples" << std::endl;
+    for (const QueueTelemetry::Summary& s : summaries) {
+        std::cout << "  " << std::left << std::setw(24) << s.name << std::right
+                  << "now=" << s.latest << " min=" << s.min
+                  << " mean=" << std::fixed << std::setprecision(1) << s.mean
+                  << " max=" << s.max << " high-water=" << s.high_water;
+        if (s.capacity > 0) {
+            std::cout << " (" << std::setprecision(1)
+                      << (100.0 * static_cast<double>(s.high_water) / static_cast<double>(s.capacity))
+                      << "% of " << s.capacity << ")";
+        }
+        std::cout << " at " << std::setprecision(1) << s.high_water_at_s << " s" << std::endl;
+    }
+}
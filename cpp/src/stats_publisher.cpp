@@ -0,0 +1,268 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "stats_publisher.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+template <typename T>
+void write_json_array(std::ostringstream& out, const std::vector<T>& values) {
+    out << "[";
+    for (size_t i = 0; i < values.size(); ++i) {
+        out << (i ? "," : "") << values[i];
+    }
+    out << "]";
+}
+
+uint64_t unix_time_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+}  // namespace
+
+std::string statistics_to_json(const Statistics& stats, uint64_t sequence, double elapsed_s) {
+    std::ostringstream out;
+    out << std::setprecision(10);
+    out << "{\"seq\":" << sequence
+        << ",\"unix_time_ns\":" << unix_time_ns()
+        << ",\"elapsed_s\":" << elapsed_s
+        << ",\"total_hits\":" << stats.total_hits
+        << ",\"total_chunks\":" << stats.total_chunks
+        << ",\"total_tdc_events\":" << stats.total_tdc_events
+        << ",\"total_tdc1_events\":" << stats.total_tdc1_events
+        << ",\"total_tdc2_events\":" << stats.total_tdc2_events
+        << ",\"total_control_packets\":" << stats.total_control_packets
+        << ",\"total_decode_errors\":" << stats.total_decode_errors
+        << ",\"total_fractional_errors\":" << stats.total_fractional_errors
+        << ",\"total_unknown_packets\":" << stats.total_unknown_packets
+        << ",\"hit_rate_hz\":" << stats.hit_rate_hz
+        << ",\"tdc1_rate_hz\":" << stats.tdc1_rate_hz
+        << ",\"tdc2_rate_hz\":" << stats.tdc2_rate_hz
+        << ",\"cumulative_hit_rate_hz\":" << stats.cumulative_hit_rate_hz
+        << ",\"cumulative_tdc1_rate_hz\":" << stats.cumulative_tdc1_rate_hz
+        << ",\"cumulative_tdc2_rate_hz\":" << stats.cumulative_tdc2_rate_hz
+        << ",\"chip_index_out_of_range\":" << stats.chip_index_out_of_range
+        << ",\"total_reordered_packets\":" << stats.total_reordered_packets
+        << ",\"reorder_max_distance\":" << stats.reorder_max_distance
+        << ",\"reorder_buffer_overflows\":" << stats.reorder_buffer_overflows
+        << ",\"reorder_packets_dropped_too_old\":" << stats.reorder_packets_dropped_too_old
+        << ",\"started_mid_stream\":" << (stats.started_mid_stream ? "true" : "false");
+    out << ",\"chip_hit_rates_hz\":";
+    write_json_array(out, stats.chip_hit_rates_hz);
+    out << ",\"chip_tdc1_counts\":";
+    write_json_array(out, stats.chip_tdc1_counts);
+    out << ",\"chip_tdc1_rates_hz\":";
+    write_json_array(out, stats.chip_tdc1_rates_hz);
+    out << ",\"packet_type_counts\":{";
+    bool first = true;
+    for (const auto& entry : stats.packet_type_counts) {
+        out << (first ? "" : ",") << "\"0x" << std::hex << static_cast<int>(entry.first) << std::dec
+            << "\":" << entry.second;
+        first = false;
+    }
+    out << "},\"packet_byte_totals\":{";
+    first = true;
+    for (const auto& entry : stats.packet_byte_totals) {
+        out << (first ? "" : ",") << "\"" << entry.first << "\":" << entry.second;
+        first = false;
+    }
+    out << "}}";
+    return out.str();
+}
+
+bool stats_shm_read(const StatsShmSegment& segment, StatsShmRecord& record, std::string& json,
+                    int max_attempts) {
+    if (segment.magic != StatsShmSegment::MAGIC || segment.version != StatsShmSegment::VERSION) {
+        return false;
+    }
+    std::vector<char> text(StatsShmSegment::JSON_CAPACITY);
+    for (int attempt = 0; attempt < max_attempts; ++attempt) {
+        uint64_t before = segment.seqlock.load(std::memory_order_acquire);
+        if (before == 0) {
+            return false;  // Nothing published yet
+        }
+        if (before & 1) {
+            continue;  // Write in progress
+        }
+        std::memcpy(&record, &segment.record, sizeof(record));
+        uint32_t length = std::min<uint32_t>(segment.json_length, StatsShmSegment::JSON_CAPACITY);
+        std::memcpy(text.data(), segment.json, length);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (segment.seqlock.load(std::memory_order_relaxed) == before) {
+            json.assign(text.data(), length);
+            return true;
+        }
+    }
+    return false;
+}
+
+StatsPublisher::StatsPublisher(const Config& config, SnapshotFn snapshot)
+    : config_(config), snapshot_(std::move(snapshot)), start_time_(std::chrono::steady_clock::now()) {
+    config_.interval = std::max(config_.interval, std::chrono::milliseconds(1));
+}
+
+StatsPublisher::~StatsPublisher() {
+    stop();
+    if (socket_fd_ >= 0) {
+        close(socket_fd_);
+    }
+    if (shm_) {
+        munmap(shm_, sizeof(StatsShmSegment));
+        shm_unlink(config_.shm_name.c_str());
+    }
+}
+
+bool StatsPublisher::open(std::string& error) {
+    if (!config_.jsonl_path.empty()) {
+        jsonl_.open(config_.jsonl_path, std::ios::out | std::ios::app);
+        if (!jsonl_) {
+            error = "cannot open " + config_.jsonl_path;
+            return false;
+        }
+    }
+    if (!config_.unix_socket_path.empty()) {
+        if (config_.unix_socket_path.size() >= sizeof(sockaddr_un::sun_path)) {
+            error = "UNIX socket path too long: " + config_.unix_socket_path;
+            return false;
+        }
+        socket_fd_ = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (socket_fd_ < 0) {
+            error = std::string("socket(AF_UNIX): ") + std::strerror(errno);
+            return false;
+        }
+    }
+    if (!config_.shm_name.empty()) {
+        int fd = shm_open(config_.shm_name.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd < 0) {
+            error = "shm_open(" + config_.shm_name + "): " + std::strerror(errno);
+            return false;
+        }
+        if (ftruncate(fd, sizeof(StatsShmSegment)) < 0) {
+            error = std::string("ftruncate: ") + std::strerror(errno);
+            close(fd);
+            return false;
+        }
+        void* memory = mmap(nullptr, sizeof(StatsShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) {
+            error = std::string("mmap: ") + std::strerror(errno);
+            return false;
+        }
+        std::memset(memory, 0, sizeof(StatsShmSegment));
+        shm_ = static_cast<StatsShmSegment*>(memory);
+        shm_->magic = StatsShmSegment::MAGIC;
+        shm_->version = StatsShmSegment::VERSION;
+    }
+    return true;
+}
+
+void StatsPublisher::start() {
+    if (thread_.joinable()) {
+        return;
+    }
+    start_time_ = std::chrono::steady_clock::now();
+    stop_requested_ = false;
+    thread_ = std::thread([this]() { publisherLoop(); });
+}
+
+void StatsPublisher::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(stop_mutex_);
+        stop_requested_ = true;
+    }
+    stop_cv_.notify_all();
+    thread_.join();
+    publish(snapshot_());
+}
+
+void StatsPublisher::publisherLoop() {
+    std::unique_lock<std::mutex> lock(stop_mutex_);
+    while (!stop_cv_.wait_for(lock, config_.interval, [this]() { return stop_requested_; })) {
+        lock.unlock();
+        publish(snapshot_());
+        lock.lock();
+    }
+}
+
+void StatsPublisher::publish(const Statistics& stats) {
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    ++sequence_;
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time_).count();
+    std::string json = statistics_to_json(stats, sequence_, elapsed_s);
+
+    if (jsonl_.is_open()) {
+        jsonl_ << json << '\n';
+        jsonl_.flush();
+    }
+    if (socket_fd_ >= 0) {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, config_.unix_socket_path.c_str(), config_.unix_socket_path.size());
+        if (sendto(socket_fd_, json.data(), json.size(), 0,
+                   reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ++socket_send_failures_;  // No listener or its queue is full
+        }
+    }
+    if (shm_) {
+        StatsShmRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.sequence = sequence_;
+        record.unix_time_ns = unix_time_ns();
+        record.elapsed_s = elapsed_s;
+        record.total_hits = stats.total_hits;
+        record.total_chunks = stats.total_chunks;
+        record.total_tdc1_events = stats.total_tdc1_events;
+        record.total_tdc2_events = stats.total_tdc2_events;
+        record.total_control_packets = stats.total_control_packets;
+        record.total_decode_errors = stats.total_decode_errors;
+        record.total_fractional_errors = stats.total_fractional_errors;
+        record.total_unknown_packets = stats.total_unknown_packets;
+        record.total_reordered_packets = stats.total_reordered_packets;
+        record.hit_rate_hz = stats.hit_rate_hz;
+        record.tdc1_rate_hz = stats.tdc1_rate_hz;
+        record.tdc2_rate_hz = stats.tdc2_rate_hz;
+        record.cumulative_hit_rate_hz = stats.cumulative_hit_rate_hz;
+        record.cumulative_tdc1_rate_hz = stats.cumulative_tdc1_rate_hz;
+        record.cumulative_tdc2_rate_hz = stats.cumulative_tdc2_rate_hz;
+        size_t chips = std::min<size_t>(stats.chip_hit_rates_hz.size(), HitProcessor::MAX_CHIP_COUNT);
+        record.chip_count = static_cast<uint32_t>(chips);
+        for (size_t chip = 0; chip < chips; ++chip) {
+            record.chip_hit_rates_hz[chip] = stats.chip_hit_rates_hz[chip];
+            if (chip < stats.chip_tdc1_counts.size()) {
+                record.chip_tdc1_counts[chip] = stats.chip_tdc1_counts[chip];
+            }
+        }
+        uint32_t length = static_cast<uint32_t>(std::min(json.size(), StatsShmSegment::JSON_CAPACITY));
+
+        // Seqlock write: odd while the payload changes
+        uint64_t seq = shm_->seqlock.load(std::memory_order_relaxed);
+        shm_->seqlock.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&shm_->record, &record, sizeof(record));
+        shm_->json_length = length;
+        std::memcpy(shm_->json, json.data(), length);
+        shm_->seqlock.store(seq + 2, std::memory_order_release);
+    }
+}
@@ -9,6 +9,8 @@
 #include "tcp_server.h"
 
 #include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
@@ -20,7 +22,9 @@
 #include <iostream>
 #include <iomanip>
 #include <chrono>
+#include <fstream>
 #include <sstream>
+#include <string>
 #include <vector>
 
 TCPServer::TCPServer(const char* host, uint16_t port)
@@ -48,6 +52,10 @@ void TCPServer::closeConnection() {
     }
     
     if (socket_ >= 0) {
+        SocketInfo info = sampleSocketInfo();
+        if (info.valid) {
+            last_socket_info_ = info;
+        }
         close(socket_);
         socket_ = -1;
     }
@@ -126,6 +134,11 @@ bool TCPServer::connect() {
     if (setsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) < 0) {
         // Not critical, continue if fails
     }
+    stats_.rcvbuf_requested = rcvbuf;
+    socklen_t rcvbuf_len = sizeof(stats_.rcvbuf_effective);
+    if (getsockopt(socket_, SOL_SOCKET, SO_RCVBUF, &stats_.rcvbuf_effective, &rcvbuf_len) < 0) {
+        stats_.rcvbuf_effective = 0;
+    }
     
     // Verify actual buffer size (may be clamped by system limits)
     // Note: Linux doubles the buffer size, so requested 64MB -> actual 50MB
@@ -176,6 +189,9 @@ bool TCPServer::connect() {
 
 void TCPServer::run(DataCallback data_cb) {
     should_stop_ = false;
+    if (!net_stats_baseline_.available) {
+        readKernelNetStats(net_stats_baseline_);
+    }
     
     while (!should_stop_) {
         // Try to connect
@@ -190,7 +206,8 @@ void TCPServer::run(DataCallback data_cb) {
         }
         
         // Connected, now read data
-        constexpr size_t BUFFER_SIZE = 1024 * 1024; // 1MB buffer for high throughput
+        // 1MB buffer for high throughput, allocated (first touched) by the network thread
+        constexpr size_t BUFFER_SIZE = RECV_BUFFER_SIZE;
         std::vector<uint8_t> buffer(BUFFER_SIZE + 8);  // Extra space for incomplete bytes
         
         while (connected_ && !should_stop_) {
@@ -262,6 +279,88 @@ void TCPServer::run(DataCallback data_cb) {
     }
 }
 
+size_t TCPServer::receiveBacklog() const {
+    int fd = socket_.load(std::memory_order_relaxed);
+    int queued = 0;
+    if (fd < 0 || ioctl(fd, SIOCINQ, &queued) < 0 || queued < 0) {
+        return 0;
+    }
+    return static_cast<size_t>(queued);
+}
+
+TCPServer::SocketInfo TCPServer::sampleSocketInfo() const {
+    SocketInfo info;
+    int fd = socket_.load(std::memory_order_relaxed);
+    if (fd < 0) {
+        return info;
+    }
+    struct tcp_info tcp;
+    std::memset(&tcp, 0, sizeof(tcp));
+    socklen_t len = sizeof(tcp);
+    if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, &tcp, &len) < 0) {
+        return info;
+    }
+    info.valid = true;
+    info.rcv_space = tcp.tcpi_rcv_space;
+    info.rcv_ssthresh = tcp.tcpi_rcv_ssthresh;
+    info.rtt_us = tcp.tcpi_rtt;
+    info.rttvar_us = tcp.tcpi_rttvar;
+    info.rcv_rtt_us = tcp.tcpi_rcv_rtt;
+    info.total_retrans = tcp.tcpi_total_retrans;
+    info.lost = tcp.tcpi_lost;
+    info.backlog_bytes = receiveBacklog();
+    return info;
+}
+
+bool TCPServer::readKernelNetStats(KernelNetStats& out) {
+    // /proc/net/netstat holds pairs of lines: "TcpExt: Name1 Name2 ..." then "TcpExt: v1 v2 ..."
+    std::ifstream netstat("/proc/net/netstat");
+    std::string names;
+    std::string values;
+    while (std::getline(netstat, names) && std::getline(netstat, values)) {
+        if (names.compare(0, 7, "TcpExt:") != 0) {
+            continue;
+        }
+        std::istringstream name_stream(names.substr(7));
+        std::istringstream value_stream(values.substr(7));
+        std::string name;
+        uint64_t value = 0;
+        while (name_stream >> name && value_stream >> value) {
+            if (name == "PruneCalled") out.prune_called = value;
+            else if (name == "RcvPruned") out.rcv_pruned = value;
+            else if (name == "OfoPruned") out.ofo_pruned = value;
+            else if (name == "TCPRcvCollapsed") out.rcv_collapsed = value;
+            else if (name == "TCPRcvQDrop") out.rcvq_drop = value;
+            else if (name == "TCPBacklogDrop") out.backlog_drop = value;
+            else if (name == "TCPToZeroWindowAdv") out.to_zero_window_adv = value;
+            else if (name == "TCPWantZeroWindowAdv") out.want_zero_window_adv = value;
+        }
+        out.available = true;
+        return true;
+    }
+    return false;
+}
+
+TCPServer::KernelNetStats TCPServer::KernelNetStats::since(const KernelNetStats& baseline) const {
+    KernelNetStats delta = *this;
+    delta.available = available && baseline.available;
+    delta.prune_called -= baseline.prune_called;
+    delta.rcv_pruned -= baseline.rcv_pruned;
+    delta.ofo_pruned -= baseline.ofo_pruned;
+    delta.rcv_collapsed -= baseline.rcv_collapsed;
+    delta.rcvq_drop -= baseline.rcvq_drop;
+    delta.backlog_drop -= baseline.backlog_drop;
+    delta.to_zero_window_adv -= baseline.to_zero_window_adv;
+    delta.want_zero_window_adv -= baseline.want_zero_window_adv;
+    return delta;
+}
+
+TCPServer::KernelNetStats TCPServer::kernelNetStatsSinceStart() const {
+    KernelNetStats current;
+    readKernelNetStats(current);
+    return current.since(net_stats_baseline_);
+}
+
 void TCPServer::stop() {
     should_stop_ = true;
     closeConnection();
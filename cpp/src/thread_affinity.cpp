@@ -0,0 +1,227 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "thread_affinity.h"
+
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <netinet/in.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+bool parse_cpu_list(const std::string& text, std::vector<int>& cpus) {
+    cpus.clear();
+    std::istringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+        size_t dash = range.find('-');
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            if (first < 0 || last < first || last >= CPU_SETSIZE) {
+                return false;
+            }
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (...) {
+            return false;
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return !cpus.empty();
+}
+
+std::string format_cpu_list(const std::vector<int>& cpus) {
+    std::ostringstream out;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            ++j;
+        }
+        out << (i ? "," : "") << cpus[i];
+        if (j > i) {
+            out << "-" << cpus[j];
+        }
+        i = j + 1;
+    }
+    return out.str();
+}
+
+bool pin_thread(pthread_t thread, const std::vector<int>& cpus, std::string& error) {
+    if (cpus.empty()) {
+        return true;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    int rc = pthread_setaffinity_np(thread, sizeof(set), &set);
+    if (rc != 0) {
+        error = "pthread_setaffinity_np(" + format_cpu_list(cpus) + "): " + std::strerror(rc);
+        return false;
+    }
+    return true;
+}
+
+bool pin_current_thread(const std::vector<int>& cpus, std::string& error) {
+    return pin_thread(pthread_self(), cpus, error);
+}
+
+std::vector<int> current_thread_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    return cpus;
+}
+
+bool set_current_thread_fifo(int priority, std::string& error) {
+    sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0) {
+        error = "SCHED_FIFO priority " + std::to_string(priority) + ": " + std::strerror(rc);
+        return false;
+    }
+    return true;
+}
+
+int numa_node_count() {
+    int count = 0;
+    while (access(("/sys/devices/system/node/node" + std::to_string(count)).c_str(), F_OK) == 0) {
+        ++count;
+    }
+    return count;
+}
+
+std::vector<int> numa_node_cpus(int node) {
+    std::vector<int> cpus;
+    if (node < 0) {
+        return cpus;
+    }
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string text;
+    if (std::getline(file, text)) {
+        parse_cpu_list(text, cpus);
+    }
+    return cpus;
+}
+
+int numa_node_of_cpu(int cpu) {
+    int nodes = numa_node_count();
+    for (int node = 0; node < nodes; ++node) {
+        std::vector<int> cpus = numa_node_cpus(node);
+        if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+            return node;
+        }
+    }
+    return -1;
+}
+
+std::string route_interface(const std::string& host, uint16_t port) {
+    // A connected UDP socket reveals the local address the route uses; nothing is sent
+    sockaddr_in remote;
+    std::memset(&remote, 0, sizeof(remote));
+    remote.sin_family = AF_INET;
+    remote.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &remote.sin_addr) <= 0) {
+        return "";
+    }
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return "";
+    }
+    sockaddr_in local;
+    socklen_t length = sizeof(local);
+    bool ok = connect(fd, reinterpret_cast<sockaddr*>(&remote), sizeof(remote)) == 0 &&
+              getsockname(fd, reinterpret_cast<sockaddr*>(&local), &length) == 0;
+    close(fd);
+    if (!ok) {
+        return "";
+    }
+    std::string interface;
+    ifaddrs* addresses = nullptr;
+    if (getifaddrs(&addresses) == 0) {
+        for (ifaddrs* entry = addresses; entry; entry = entry->ifa_next) {
+            if (entry->ifa_addr && entry->ifa_addr->sa_family == AF_INET &&
+                reinterpret_cast<sockaddr_in*>(entry->ifa_addr)->sin_addr.s_addr == local.sin_addr.s_addr) {
+                interface = entry->ifa_name;
+                break;
+            }
+        }
+        freeifaddrs(addresses);
+    }
+    return interface;
+}
+
+int interface_numa_node(const std::string& interface) {
+    if (interface.empty()) {
+        return -1;
+    }
+    std::ifstream file("/sys/class/net/" + interface + "/device/numa_node");
+    int node = -1;
+    if (!(file >> node)) {
+        return -1;
+    }
+    return node;  // The kernel reports -1 for devices without NUMA affinity
+}
+
+void ThreadPlacement::autoPlace(int node, size_t worker_count, bool network_thread) {
+    numa_node = node;
+    std::vector<int> cpus = numa_node_cpus(node);
+    std::vector<int> allowed = current_thread_cpus();
+    if (cpus.empty()) {
+        cpus = allowed;
+    } else {
+        // Only CPUs this process may run on (cgroups / taskset)
+        std::vector<int> usable;
+        std::set_intersection(cpus.begin(), cpus.end(), allowed.begin(), allowed.end(),
+                              std::back_inserter(usable));
+        if (!usable.empty()) {
+            cpus = usable;
+        }
+    }
+    if (cpus.empty()) {
+        return;
+    }
+    size_t next = 0;
+    auto take = [&cpus, &next]() { return cpus[next++ % cpus.size()]; };
+    if (network_thread && network.empty()) {
+        network = {take()};
+    }
+    if (processing.empty()) {
+        processing = {take()};
+    }
+    if (worker_count > 0 && workers.empty()) {
+        size_t remaining = cpus.size() > next ? cpus.size() - next : 0;
+        size_t count = std::max<size_t>(1, std::min(worker_count, remaining));
+        for (size_t i = 0; i < count; ++i) {
+            workers.push_back(take());
+        }
+    }
+}
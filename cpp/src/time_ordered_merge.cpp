@@ -0,0 +1,196 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "time_ordered_merge.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+constexpr uint64_t EXHAUSTED = std::numeric_limits<uint64_t>::max();
+}
+
+TimeOrderedMerger::TimeOrderedMerger(const Config& config, BatchCallback callback)
+    : config_(config)
+    , callback_(std::move(callback))
+    , active_runs_(0)
+    , next_sequence_(0)
+    , chip_progress_(256, 0)
+    , chip_seen_(256, false)
+    , newest_progress_(0)
+    , last_emitted_toa_(0)
+    , buffered_hits_(0)
+{
+    if (config_.batch_size == 0) {
+        config_.batch_size = 1;
+    }
+    batch_.reserve(config_.batch_size);
+}
+
+void TimeOrderedMerger::pushRun(uint8_t chip_index, HitBlock&& run, uint64_t chip_progress_ticks) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.runs_received++;
+    stats_.hits_received += run.size();
+    
+    if (!chip_seen_[chip_index] || chip_progress_ticks > chip_progress_[chip_index]) {
+        chip_progress_[chip_index] = chip_progress_ticks;
+        chip_seen_[chip_index] = true;
+    }
+    newest_progress_ = std::max(newest_progress_, chip_progress_ticks);
+    
+    if (!run.empty()) {
+        buffered_hits_ += run.size();
+        uint32_t slot = takeSlot();
+        runs_[slot].hits = std::move(run);
+        runs_[slot].cursor = 0;
+        runs_[slot].sequence = next_sequence_++;
+        replay(slot);
+        active_runs_++;
+        stats_.max_buffered_hits = std::max<uint64_t>(stats_.max_buffered_hits, buffered_hits_);
+        stats_.max_pending_runs = std::max<uint64_t>(stats_.max_pending_runs, active_runs_);
+    }
+    
+    drainLocked(watermark(), config_.max_buffered_hits);
+}
+
+void TimeOrderedMerger::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    drainLocked(EXHAUSTED, 0);
+}
+
+TimeOrderedMerger::Statistics TimeOrderedMerger::getStatistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+size_t TimeOrderedMerger::bufferedHits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return buffered_hits_;
+}
+
+uint64_t TimeOrderedMerger::watermark() const {
+    uint64_t min_progress = EXHAUSTED;
+    for (size_t chip = 0; chip < chip_seen_.size(); ++chip) {
+        if (chip_seen_[chip] || chip < config_.expected_chips) {
+            min_progress = std::min(min_progress, chip_progress_[chip]);
+        }
+    }
+    if (min_progress == EXHAUSTED) {
+        return 0;
+    }
+    // A chip lagging more than max_delay behind the newest data no longer holds back output
+    uint64_t delayed = (newest_progress_ > config_.max_delay_ticks)
+        ? (newest_progress_ - config_.max_delay_ticks)
+        : 0;
+    uint64_t base = std::max(min_progress, delayed);
+    return (base > config_.lateness_ticks) ? (base - config_.lateness_ticks) : 0;
+}
+
+void TimeOrderedMerger::drainLocked(uint64_t limit, size_t keep_buffered) {
+    if (active_runs_ == 0) {
+        return;
+    }
+    
+    while (true) {
+        uint32_t winner = tree_[1];
+        uint64_t key = runKey(winner);
+        if (key == EXHAUSTED) {
+            break;
+        }
+        bool over_memory = buffered_hits_ > keep_buffered;
+        if (key > limit && !over_memory) {
+            break;
+        }
+        if (key > limit) {
+            stats_.forced_hits++;
+        }
+        if (key < last_emitted_toa_) {
+            stats_.late_hits++;
+        } else {
+            last_emitted_toa_ = key;
+        }
+        
+        Run& run = runs_[winner];
+        batch_.push_back(run.hits, run.cursor);
+        run.cursor++;
+        buffered_hits_--;
+        stats_.hits_emitted++;
+        if (batch_.size() >= config_.batch_size) {
+            emitBatchLocked();
+        }
+        if (run.cursor >= run.hits.size()) {
+            // Exhausted: release the hits, the slot keeps losing until reused
+            run.hits = HitBlock();
+            run.cursor = 0;
+            free_slots_.push_back(winner);
+            active_runs_--;
+        }
+        replay(winner);
+    }
+    emitBatchLocked();
+}
+
+uint64_t TimeOrderedMerger::runKey(uint32_t run) const {
+    const Run& r = runs_[run];
+    return (r.cursor < r.hits.size()) ? r.hits.toa[r.cursor] : EXHAUSTED;
+}
+
+bool TimeOrderedMerger::runBefore(uint32_t a, uint32_t b) const {
+    uint64_t key_a = runKey(a);
+    uint64_t key_b = runKey(b);
+    // Ties broken by push order (earlier pushed run first) for deterministic output
+    return key_a < key_b || (key_a == key_b && runs_[a].sequence < runs_[b].sequence);
+}
+
+uint32_t TimeOrderedMerger::takeSlot() {
+    if (free_slots_.empty()) {
+        // Double the slots; the new ones are empty until taken
+        size_t old_slots = runs_.size();
+        size_t new_slots = std::max<size_t>(4, 2 * old_slots);
+        runs_.resize(new_slots);
+        for (size_t slot = new_slots; slot-- > old_slots;) {
+            free_slots_.push_back(static_cast<uint32_t>(slot));
+        }
+        buildTree();
+    }
+    uint32_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    return slot;
+}
+
+void TimeOrderedMerger::buildTree() {
+    const size_t k = runs_.size();
+    tree_.assign(2 * k, 0);
+    for (size_t i = 0; i < k; ++i) {
+        tree_[k + i] = static_cast<uint32_t>(i);
+    }
+    for (size_t node = k - 1; node >= 1; --node) {
+        uint32_t left = tree_[2 * node];
+        uint32_t right = tree_[2 * node + 1];
+        tree_[node] = runBefore(right, left) ? right : left;
+    }
+}
+
+void TimeOrderedMerger::replay(uint32_t run) {
+    const size_t k = runs_.size();
+    for (size_t node = (run + k) / 2; node >= 1; node /= 2) {
+        uint32_t left = tree_[2 * node];
+        uint32_t right = tree_[2 * node + 1];
+        tree_[node] = runBefore(right, left) ? right : left;
+    }
+}
+
+void TimeOrderedMerger::emitBatchLocked() {
+    if (batch_.empty()) {
+        return;
+    }
+    stats_.batches_emitted++;
+    if (callback_) {
+        callback_(batch_);
+    }
+    batch_.clear();
+}
@@ -0,0 +1,110 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "time_walk.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+TimeWalkCorrection::TimeWalkCorrection() : tables_(256) {
+}
+
+bool TimeWalkCorrection::loadFromFile(const std::string& path, std::string& error) {
+    std::ifstream input(path);
+    if (!input) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::string line;
+    size_t line_number = 0;
+    size_t loaded = 0;
+    while (std::getline(input, line)) {
+        ++line_number;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.erase(comment);
+        }
+        std::istringstream fields(line);
+        unsigned chip;
+        double a, b, c;
+        if (!(fields >> chip)) {
+            continue;  // Blank or comment line
+        }
+        if (!(fields >> a >> b >> c) || chip > 255 || !setChip(static_cast<uint8_t>(chip), a, b, c)) {
+            error = path + ":" + std::to_string(line_number) + ": expected 'chip a b c' with a >= 0, c > 0";
+            return false;
+        }
+        loaded++;
+    }
+    if (loaded == 0) {
+        error = "no chip parameters in " + path;
+        return false;
+    }
+    return true;
+}
+
+bool TimeWalkCorrection::setChip(uint8_t chip, double a, double b, double c) {
+    if (!(a >= 0.0) || !(c > 0.0) || !std::isfinite(a) || !std::isfinite(b)) {
+        return false;
+    }
+    std::vector<uint32_t>& table = tables_[chip];
+    table.assign(TOT_COUNTS, 0);
+    // First ToT count where the model is defined
+    double first_valid = std::max(0.0, std::floor(b / TOT_NS_PER_COUNT) + 1.0);
+    for (size_t count = 0; count < TOT_COUNTS; ++count) {
+        double tot_ns = std::max<double>(count, first_valid) * TOT_NS_PER_COUNT;
+        double delay_ticks = a / std::pow(tot_ns - b, c) * TICKS_PER_NS;
+        table[count] = static_cast<uint32_t>(std::min(std::round(delay_ticks),
+            static_cast<double>(std::numeric_limits<uint32_t>::max())));
+    }
+    return true;
+}
+
+void TimeWalkCorrection::apply(HitBlock& block) const {
+    const size_t n = block.size();
+    size_t begin = 0;
+    // Chunk runs hold one chip, so this is normally a single segment
+    while (begin < n) {
+        uint8_t chip = block.chip[begin];
+        size_t end = begin + 1;
+        while (end < n && block.chip[end] == chip) {
+            ++end;
+        }
+        const std::vector<uint32_t>& table = tables_[chip];
+        if (!table.empty()) {
+            const uint32_t* delay = table.data();
+            const uint16_t* tot = block.tot.data();
+            uint64_t* toa = block.toa.data();
+            for (size_t i = begin; i < end; ++i) {
+                uint64_t d = delay[(tot[i] / TOT_NS_PER_COUNT) & (TOT_COUNTS - 1)];
+                toa[i] -= std::min(toa[i], d);
+            }
+        }
+        begin = end;
+    }
+}
+
+size_t TimeWalkCorrection::correctedChips() const {
+    size_t count = 0;
+    for (const auto& table : tables_) {
+        if (!table.empty()) {
+            count++;
+        }
+    }
+    return count;
+}
+
+uint32_t TimeWalkCorrection::delayTicks(uint8_t chip, uint16_t tot_ns) const {
+    const std::vector<uint32_t>& table = tables_[chip];
+    if (table.empty()) {
+        return 0;
+    }
+    return table[(tot_ns / TOT_NS_PER_COUNT) & (TOT_COUNTS - 1)];
+}
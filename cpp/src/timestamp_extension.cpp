@@ -13,3 +13,34 @@ void extend_pixel_hit_timestamp(PixelHit& hit, uint64_t minimum_timestamp, uint6
     hit.toa_ns = extend_timestamp(hit.toa_ns, minimum_timestamp, n_bits);
 }
 
+TimestampExtender::TimestampExtender() : states_(256) {}
+
+void TimestampExtender::updateGlobalTime(uint8_t chip_index, const GlobalTime& gt) {
+    ChipState& state = states_[chip_index];
+    state.global_packets++;
+    if (!gt.is_high_word) {
+        // Low word: 32 bits of 25ns units (~107 s). Place it relative to the
+        // current reference so the low counter's own wrap is tracked too.
+        state.global_low = gt.time_value;
+        state.has_global_low = true;
+        uint64_t ticks = static_cast<uint64_t>(gt.time_value) << 4;
+        state.reference = extend_timestamp(ticks, windowStart(state.reference, GLOBAL_LOW_BITS),
+                                           GLOBAL_LOW_BITS);
+    } else if (state.has_global_low) {
+        // High word: bits 47-32 of the 25ns counter, authoritative full time
+        uint64_t global_25ns = (static_cast<uint64_t>(gt.time_value) << 32) | state.global_low;
+        state.reference = global_25ns << 4;
+    }
+}
+
+uint64_t TimestampExtender::globalTimePackets() const {
+    uint64_t total = 0;
+    for (const auto& state : states_) {
+        total += state.global_packets;
+    }
+    return total;
+}
+
+void TimestampExtender::reset() {
+    states_.assign(states_.size(), ChipState{});
+}
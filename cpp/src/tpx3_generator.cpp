@@ -0,0 +1,335 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+#include "tpx3_generator.h"
+#include "tpx3_packets.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double TICKS_PER_SECOND = 640.0e6;  // 1.5625ns
+constexpr int CHIP_PIXELS = 256;
+constexpr uint64_t TDC_PULSE_TICKS = 640;     // 1us between TDC1 rise and fall
+
+// Samplers built on the raw engine output only, so a seed gives the same
+// stream with any standard library (std:: distributions are not portable)
+double uniform01(std::mt19937_64& rng) {
+    return static_cast<double>(rng() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+uint64_t uniform_below(std::mt19937_64& rng, uint64_t n) {
+    return n == 0 ? 0 : static_cast<uint64_t>(uniform01(rng) * static_cast<double>(n));
+}
+
+double normal(std::mt19937_64& rng) {
+    double u1 = 1.0 - uniform01(rng);  // (0, 1]
+    double u2 = uniform01(rng);
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+}
+
+uint64_t poisson(std::mt19937_64& rng, double mean) {
+    if (mean <= 0.0) {
+        return 0;
+    }
+    if (mean > 30.0) {
+        double value = std::round(mean + std::sqrt(mean) * normal(rng));
+        return value > 0.0 ? static_cast<uint64_t>(value) : 0;
+    }
+    double limit = std::exp(-mean);
+    double product = uniform01(rng);
+    uint64_t k = 0;
+    while (product > limit) {
+        product *= uniform01(rng);
+        ++k;
+    }
+    return k;
+}
+
+uint64_t pixaddr(uint16_t x, uint16_t y) {
+    return ((x >> 1) << 9) | ((y >> 2) << 3) | ((x & 1) << 2) | (y & 3);
+}
+
+}  // namespace
+
+uint64_t encode_pixel_standard(uint16_t x, uint16_t y, uint64_t toa_ticks, uint16_t tot_counts) {
+    // toa_ticks = (coarse << 4) - ftoa with coarse = (spidr << 14) + toa
+    uint64_t coarse = (toa_ticks + 15) >> 4;
+    uint64_t ftoa = (coarse << 4) - toa_ticks;
+    return (static_cast<uint64_t>(PIXEL_STANDARD) << 60) | (pixaddr(x, y) << 44) |
+           ((coarse & 0x3FFF) << 30) | (static_cast<uint64_t>(tot_counts & 0x3FF) << 20) |
+           (ftoa << 16) | ((coarse >> 14) & 0xFFFF);
+}
+
+uint64_t encode_pixel_count_fb(uint16_t x, uint16_t y, uint64_t toa_ticks, uint16_t tot_counts) {
+    // Integrated ToT, one event and one hit; only the SPIDR time carries time
+    uint64_t coarse = (toa_ticks + 15) >> 4;
+    return (static_cast<uint64_t>(PIXEL_COUNT_FB) << 60) | (pixaddr(x, y) << 44) |
+           (static_cast<uint64_t>(tot_counts & 0x3FFF) << 30) | (1ULL << 20) | (1ULL << 16) |
+           ((coarse >> 14) & 0xFFFF);
+}
+
+uint64_t encode_tdc(uint8_t type, uint16_t trigger_count, uint64_t timestamp_ticks, uint8_t fract) {
+    // timestamp = (coarse << 1) | ((fract - 1) / 6); the caller picks a fract
+    // consistent with the low bit (1-6 even, 7-12 odd) or a bad one on purpose
+    uint64_t coarse = (timestamp_ticks >> 1) & ((1ULL << 35) - 1);
+    return (static_cast<uint64_t>(TDC_DATA) << 60) | (static_cast<uint64_t>(type & 0xF) << 56) |
+           (static_cast<uint64_t>(trigger_count & 0xFFF) << 44) | (coarse << 9) |
+           (static_cast<uint64_t>(fract & 0xF) << 5);
+}
+
+uint64_t encode_global_time_low(uint64_t time_25ns) {
+    return (static_cast<uint64_t>(GLOBAL_TIME_LOW) << 56) | ((time_25ns & 0xFFFFFFFFULL) << 16) |
+           ((time_25ns >> 14) & 0xFFFF);
+}
+
+uint64_t encode_global_time_high(uint64_t time_25ns) {
+    return (static_cast<uint64_t>(GLOBAL_TIME_HIGH) << 56) | (((time_25ns >> 32) & 0xFFFF) << 16) |
+           ((time_25ns >> 14) & 0xFFFF);
+}
+
+uint64_t encode_spidr_packet_id(uint64_t packet_count) {
+    return (static_cast<uint64_t>(SPIDR_PACKET_ID) << 56) | (packet_count & ((1ULL << 48) - 1));
+}
+
+uint64_t encode_extra_timestamp(uint64_t timestamp_ticks) {
+    return (static_cast<uint64_t>(EXTRA_TIMESTAMP) << 56) | (timestamp_ticks & ((1ULL << 54) - 1));
+}
+
+uint64_t encode_chunk_header(uint8_t chip_index, size_t data_words) {
+    return TPX3_MAGIC | (static_cast<uint64_t>(chip_index) << 32) |
+           (static_cast<uint64_t>((data_words * 8) & 0xFFFF) << 48);
+}
+
+Tpx3Generator::Tpx3Generator(const Config& config)
+    : config_(config),
+      rng_(config.seed),
+      period_(0),
+      trigger_count_(0),
+      packet_counts_(std::max<size_t>(1, std::min<size_t>(config.chip_count, 256)), 0),
+      pending_index_(0) {
+    config_.chip_count = packet_counts_.size();
+    config_.cluster_size_mean = std::max(1.0, config_.cluster_size_mean);
+    config_.hot_chip_share = std::min(1.0, std::max(0.0, config_.hot_chip_share));
+    period_ticks_ = std::max<uint64_t>(16, static_cast<uint64_t>(config_.chunk_period_s * TICKS_PER_SECOND));
+    total_periods_ = static_cast<uint64_t>(
+        std::ceil(config_.duration_s * TICKS_PER_SECOND / static_cast<double>(period_ticks_)));
+    global_interval_ticks_ = static_cast<uint64_t>(config_.global_time_interval_s * TICKS_PER_SECOND);
+    next_global_ticks_ = config_.start_ticks;
+    next_tdc_ticks_ = config_.start_ticks;
+}
+
+double Tpx3Generator::dataTime() const {
+    return static_cast<double>(period_ * period_ticks_) / TICKS_PER_SECOND;
+}
+
+bool Tpx3Generator::nextChunk(std::vector<uint64_t>& out) {
+    while (pending_index_ >= pending_.size()) {
+        if (done()) {
+            return false;
+        }
+        pending_.clear();
+        pending_index_ = 0;
+        generatePeriod();
+    }
+    const std::vector<uint64_t>& chunk = pending_[pending_index_++];
+    out.insert(out.end(), chunk.begin(), chunk.end());
+    return true;
+}
+
+void Tpx3Generator::generatePeriod() {
+    uint64_t begin = config_.start_ticks + period_ * period_ticks_;
+    uint64_t end = begin + period_ticks_;
+    for (size_t chip = 0; chip < config_.chip_count; ++chip) {
+        generateChip(static_cast<uint8_t>(chip), begin, end);
+    }
+    if (global_interval_ticks_ > 0) {
+        while (next_global_ticks_ < end) {
+            next_global_ticks_ += global_interval_ticks_;
+        }
+    }
+    ++period_;
+}
+
+void Tpx3Generator::generateChip(uint8_t chip, uint64_t begin, uint64_t end) {
+    words_.clear();
+
+    // Global time first, so the timestamp extender has a reference
+    if (global_interval_ticks_ > 0 && next_global_ticks_ < end) {
+        uint64_t time_25ns = begin >> 4;
+        words_.push_back({encode_global_time_low(time_25ns), NO_TIME});
+        words_.push_back({encode_global_time_high(time_25ns), NO_TIME});
+        stats_.global_time_pairs++;
+    }
+
+    if (config_.tdc_frequency_hz > 0.0 && chip == config_.tdc_chip) {
+        uint64_t interval = std::max<uint64_t>(
+            2 * TDC_PULSE_TICKS, static_cast<uint64_t>(TICKS_PER_SECOND / config_.tdc_frequency_hz));
+        while (next_tdc_ticks_ < end) {
+            for (uint64_t t : {next_tdc_ticks_, next_tdc_ticks_ + TDC_PULSE_TICKS}) {
+                uint8_t type = t == next_tdc_ticks_ ? TDC1_RISE : TDC1_FALL;
+                uint8_t fract = static_cast<uint8_t>(1 + 6 * (t & 1) + uniform_below(rng_, 6));
+                if (config_.fault_bad_tdc_fraction > 0.0 && uniform01(rng_) < config_.fault_bad_tdc_fraction) {
+                    fract = static_cast<uint8_t>(13 + uniform_below(rng_, 3));
+                    stats_.faults_bad_tdc_fraction++;
+                }
+                words_.push_back({encode_tdc(type, trigger_count_, t, fract), NO_TIME});
+            }
+            trigger_count_ = static_cast<uint16_t>((trigger_count_ + 1) & 0xFFF);
+            stats_.tdc_events++;
+            next_tdc_ticks_ += interval;
+        }
+    }
+
+    // Events for this chip and period
+    double period_s = static_cast<double>(end - begin) / TICKS_PER_SECOND;
+    double chip_share = 1.0 / static_cast<double>(config_.chip_count);
+    if (config_.hot_chip_share > 0.0 && config_.chip_count > 1) {
+        chip_share = chip == 0 ? config_.hot_chip_share
+                               : (1.0 - config_.hot_chip_share) / static_cast<double>(config_.chip_count - 1);
+    }
+    double event_rate = config_.hit_rate_hz * chip_share / config_.cluster_size_mean;
+    uint64_t events = poisson(rng_, event_rate * period_s);
+    hits_.clear();
+    for (uint64_t e = 0; e < events; ++e) {
+        addEvent(hits_, begin, end);
+    }
+    stats_.events += events;
+    stats_.hits += hits_.size();
+
+    // Readout order: by double column, in time within a column
+    std::sort(hits_.begin(), hits_.end(), [](const Hit& a, const Hit& b) {
+        int dcol_a = a.x >> 1;
+        int dcol_b = b.x >> 1;
+        return dcol_a != dcol_b ? dcol_a < dcol_b : a.toa < b.toa;
+    });
+    for (const Hit& hit : hits_) {
+        uint64_t word = config_.count_fb ? encode_pixel_count_fb(hit.x, hit.y, hit.toa, hit.tot)
+                                         : encode_pixel_standard(hit.x, hit.y, hit.toa, hit.tot);
+        words_.push_back({word, hit.toa});
+    }
+
+    insertPacketIds(chip, words_);
+    emitChunks(chip, words_, end);
+}
+
+void Tpx3Generator::addEvent(std::vector<Hit>& hits, uint64_t begin, uint64_t end) {
+    uint64_t t0 = begin + uniform_below(rng_, end - begin);
+
+    int cx, cy;
+    if (config_.beam_sigma_px > 0.0) {
+        cx = static_cast<int>(std::lround(127.5 + config_.beam_sigma_px * normal(rng_)));
+        cy = static_cast<int>(std::lround(127.5 + config_.beam_sigma_px * normal(rng_)));
+        cx = std::min(CHIP_PIXELS - 1, std::max(0, cx));
+        cy = std::min(CHIP_PIXELS - 1, std::max(0, cy));
+    } else {
+        cx = static_cast<int>(uniform_below(rng_, CHIP_PIXELS));
+        cy = static_cast<int>(uniform_below(rng_, CHIP_PIXELS));
+    }
+
+    // Cluster: grow by random steps to 8-neighbours of pixels already in it
+    size_t size = 1 + poisson(rng_, config_.cluster_size_mean - 1.0);
+    size_t first = hits.size();
+    hits.push_back({t0, static_cast<uint16_t>(cx), static_cast<uint16_t>(cy), 0});
+    for (size_t attempt = 0; hits.size() - first < size && attempt < 8 * size; ++attempt) {
+        const Hit& from = hits[first + uniform_below(rng_, hits.size() - first)];
+        int x = from.x + static_cast<int>(uniform_below(rng_, 3)) - 1;
+        int y = from.y + static_cast<int>(uniform_below(rng_, 3)) - 1;
+        if (x < 0 || y < 0 || x >= CHIP_PIXELS || y >= CHIP_PIXELS) {
+            continue;
+        }
+        bool taken = false;
+        for (size_t i = first; i < hits.size(); ++i) {
+            taken |= hits[i].x == x && hits[i].y == y;
+        }
+        if (!taken) {
+            hits.push_back({t0, static_cast<uint16_t>(x), static_cast<uint16_t>(y), 0});
+        }
+    }
+
+    // Charge falls off with distance from the centre; small signals cross
+    // the threshold later (time walk, about 250ns / ToT counts)
+    double deposit = 20.0 + 180.0 * uniform01(rng_);  // ToT counts at the centre
+    for (size_t i = first; i < hits.size(); ++i) {
+        double dx = hits[i].x - cx;
+        double dy = hits[i].y - cy;
+        double tot = deposit / (1.0 + dx * dx + dy * dy) * (0.9 + 0.2 * uniform01(rng_));
+        uint16_t counts = static_cast<uint16_t>(std::min(1023.0, std::max(1.0, std::round(tot))));
+        hits[i].tot = counts;
+        hits[i].toa = t0 + 160 / counts;
+    }
+}
+
+void Tpx3Generator::insertPacketIds(uint8_t chip, std::vector<Word>& words) {
+    size_t interval = config_.packet_id_interval;
+    if (interval == 0) {
+        return;
+    }
+    std::vector<Word> with_ids;
+    with_ids.reserve(words.size() + words.size() / interval + 1);
+    std::vector<size_t> id_positions;
+    for (size_t i = 0; i < words.size(); ++i) {
+        if (i % interval == 0) {
+            id_positions.push_back(with_ids.size());
+            with_ids.push_back({encode_spidr_packet_id(packet_counts_[chip]++), NO_TIME});
+            stats_.packet_ids++;
+        }
+        with_ids.push_back(words[i]);
+    }
+    // Out-of-order fault: two consecutive packet IDs trade places
+    if (config_.fault_packet_id_swap > 0.0) {
+        for (size_t i = 0; i + 1 < id_positions.size(); ++i) {
+            if (uniform01(rng_) < config_.fault_packet_id_swap) {
+                std::swap(with_ids[id_positions[i]], with_ids[id_positions[i + 1]]);
+                stats_.faults_packet_id_swap++;
+                ++i;
+            }
+        }
+    }
+    words.swap(with_ids);
+}
+
+void Tpx3Generator::emitChunks(uint8_t chip, const std::vector<Word>& words, uint64_t generated) {
+    const size_t trailer_words = config_.extra_timestamps ? 3 : 0;
+    const size_t piece_words = MAX_CHUNK_WORDS - trailer_words;
+    size_t offset = 0;
+    do {
+        size_t count = std::min(piece_words, words.size() - offset);
+        std::vector<uint64_t> chunk;
+        chunk.reserve(1 + count + trailer_words);
+        chunk.push_back(encode_chunk_header(chip, count + trailer_words));
+        uint64_t min_toa = NO_TIME;
+        uint64_t max_toa = 0;
+        for (size_t i = offset; i < offset + count; ++i) {
+            chunk.push_back(words[i].word);
+            if (words[i].toa != NO_TIME) {
+                min_toa = std::min(min_toa, words[i].toa);
+                max_toa = std::max(max_toa, words[i].toa);
+            }
+        }
+        if (trailer_words > 0) {
+            if (min_toa == NO_TIME) {
+                min_toa = max_toa = generated;
+            }
+            chunk.push_back(encode_extra_timestamp(generated));
+            chunk.push_back(encode_extra_timestamp(min_toa));
+            chunk.push_back(encode_extra_timestamp(max_toa));
+        }
+        // Truncation fault: the header still announces the full size
+        if (chunk.size() > 1 && config_.fault_truncated_chunk > 0.0 &&
+            uniform01(rng_) < config_.fault_truncated_chunk) {
+            size_t data_words = chunk.size() - 1;
+            chunk.resize(chunk.size() - 1 - uniform_below(rng_, (data_words + 1) / 2));
+            stats_.faults_truncated_chunk++;
+        }
+        stats_.chunks++;
+        stats_.words += chunk.size();
+        pending_.push_back(std::move(chunk));
+        offset += count;
+    } while (offset < words.size());
+}
@@ -0,0 +1,365 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+// Microbenchmarks of the per-word hot-path kernels: pixel and TDC decoding,
+// pixel address conversion, timestamp extension, the packet reorder buffer
+// HitProcessor::addHit and the chunk ToA sorts (radix against stable and
+// unstable std:: comparison sorts). Each kernel runs over a pre-generated input
+// array; the best of several repetitions is reported as ns/op and, where
+// the kernel's perf_event counters are available, cycles/op.
+
+#include "hit_processor.h"
+#include "hit_sort.h"
+#include "packet_reorder_buffer.h"
+#include "timestamp_extension.h"
+#include "tpx3_decoder.h"
+#include "tpx3_generator.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// User-space CPU cycle counter for the calling thread; inactive when the
+// kernel or hypervisor does not expose one (cycles are then not reported)
+class CycleCounter {
+public:
+    CycleCounter() : fd_(-1) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+    ~CycleCounter() {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+    }
+    CycleCounter(const CycleCounter&) = delete;
+    CycleCounter& operator=(const CycleCounter&) = delete;
+
+    bool available() const { return fd_ >= 0; }
+
+    void start() {
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    uint64_t stop() {
+        uint64_t cycles = 0;
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd_, &cycles, sizeof(cycles)) != sizeof(cycles)) {
+                cycles = 0;
+            }
+        }
+        return cycles;
+    }
+
+private:
+    int fd_;
+};
+
+struct KernelResult {
+    std::string name;
+    size_t ops = 0;
+    double ns_per_op = 0.0;
+    double cycles_per_op = 0.0;  // 0 when no cycle counter
+};
+
+// Keeps results observable so kernels are not optimized away
+volatile uint64_t g_sink = 0;
+
+using Clock = std::chrono::steady_clock;
+
+// Best of `repetitions` runs of `body`, which performs `ops` operations
+KernelResult measure(const std::string& name, size_t ops, int repetitions, CycleCounter& counter,
+                     const std::function<uint64_t()>& body) {
+    KernelResult result;
+    result.name = name;
+    result.ops = ops;
+    double best_ns = 0.0;
+    uint64_t best_cycles = 0;
+    for (int r = 0; r < repetitions; ++r) {
+        Clock::time_point start = Clock::now();
+        counter.start();
+        uint64_t value = body();
+        uint64_t cycles = counter.stop();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        g_sink = g_sink + value;
+        if (r == 0 || ns < best_ns) {
+            best_ns = ns;
+            best_cycles = cycles;
+        }
+    }
+    result.ns_per_op = best_ns / static_cast<double>(ops);
+    result.cycles_per_op = static_cast<double>(best_cycles) / static_cast<double>(ops);
+    return result;
+}
+
+// Chunk-sized blocks of random ToA (all columns filled, as a collector run is)
+std::vector<HitBlock> makeSortBlocks(size_t ops, size_t block_hits, uint64_t toa_span, std::mt19937_64& rng) {
+    std::vector<HitBlock> blocks(std::max<size_t>(1, ops / block_hits));
+    for (HitBlock& block : blocks) {
+        block.reserve(block_hits);
+        for (size_t i = 0; i < block_hits; ++i) {
+            block.toa.push_back((1ULL << 40) + (rng() & (toa_span - 1)));
+            block.x.push_back(static_cast<uint16_t>(rng() & 0xFF));
+            block.y.push_back(static_cast<uint16_t>(rng() & 0xFF));
+            block.tot.push_back(static_cast<uint16_t>(rng() & 0x3FF));
+            block.chip.push_back(0);
+            block.count_fb.push_back(0);
+            block.energy.push_back(0.0f);
+        }
+    }
+    return blocks;
+}
+
+// Unstable comparison sort with the same index/permute shape as sort_hits_by_toa
+void std_sort_hits_by_toa(HitBlock& block) {
+    std::vector<uint32_t> order(block.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&block](uint32_t a, uint32_t b) { return block.toa[a] < block.toa[b]; });
+    block.permute(order);
+}
+
+void printUsage(const char* prog_name) {
+    std::cout << "Usage: " << prog_name << " [OPTIONS]\n"
+              << "Options:\n"
+              << "  --ops N          Operations per kernel run (default: 1000000)\n"
+              << "  --repetitions N  Runs per kernel, best is reported (default: 5)\n"
+              << "  --json FILE      Also write results as JSON\n"
+              << "  --help           Show this help message\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t ops = 1000000;
+    int repetitions = 5;
+    std::string json_file;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--ops" && i + 1 < argc) {
+            ops = std::max<size_t>(1, std::stoul(argv[++i]));
+        } else if (arg == "--repetitions" && i + 1 < argc) {
+            repetitions = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_file = argv[++i];
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Inputs: realistic pixel words from the generator, valid TDC words,
+    // raw pixel addresses and 30-bit ToA values spread over a wrap
+    std::mt19937_64 rng(1);
+    std::vector<uint64_t> pixel_words;
+    pixel_words.reserve(ops);
+    for (size_t i = 0; i < ops; ++i) {
+        uint64_t toa = (rng() >> 24) & ((1ULL << 34) - 1);
+        pixel_words.push_back(encode_pixel_standard(static_cast<uint16_t>(rng() & 0xFF),
+                                                    static_cast<uint16_t>(rng() & 0xFF), toa,
+                                                    static_cast<uint16_t>(1 + (rng() & 0x1FF))));
+    }
+    std::vector<uint64_t> tdc_words;
+    tdc_words.reserve(ops);
+    for (size_t i = 0; i < ops; ++i) {
+        uint64_t t = rng() & ((1ULL << 36) - 1);
+        tdc_words.push_back(encode_tdc(TDC1_RISE, static_cast<uint16_t>(i & 0xFFF), t,
+                                       static_cast<uint8_t>(1 + 6 * (t & 1) + (rng() % 6))));
+    }
+    std::vector<uint16_t> addresses(ops);
+    std::vector<uint64_t> toa30(ops);
+    for (size_t i = 0; i < ops; ++i) {
+        addresses[i] = static_cast<uint16_t>(rng());
+        toa30[i] = rng() & 0x3FFFFFFF;
+    }
+    std::vector<PixelHit> hits(ops);
+    for (size_t i = 0; i < ops; ++i) {
+        hits[i] = decode_pixel_data(pixel_words[i], static_cast<uint8_t>(i & 3));
+    }
+    // Packet IDs in order, with every 16th pair swapped
+    std::vector<uint64_t> packet_ids(ops);
+    for (size_t i = 0; i < ops; ++i) {
+        packet_ids[i] = i;
+    }
+    for (size_t i = 0; i + 1 < ops; i += 16) {
+        std::swap(packet_ids[i], packet_ids[i + 1]);
+    }
+
+    CycleCounter counter;
+    std::vector<KernelResult> results;
+
+    results.push_back(measure("decode_pixel_data", ops, repetitions, counter, [&]() {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < ops; ++i) {
+            PixelHit hit = decode_pixel_data(pixel_words[i], 0);
+            sum += hit.toa_ns + hit.x + hit.tot_ns;
+        }
+        return sum;
+    }));
+
+    results.push_back(measure("decode_tdc_data", ops, repetitions, counter, [&]() {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < ops; ++i) {
+            sum += decode_tdc_data(tdc_words[i]).timestamp_ns;
+        }
+        return sum;
+    }));
+
+    results.push_back(measure("pixaddr_to_xy", ops, repetitions, counter, [&]() {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < ops; ++i) {
+            uint16_t x, y;
+            std::tie(x, y) = pixaddr_to_xy(addresses[i]);
+            sum += x * 256u + y;
+        }
+        return sum;
+    }));
+
+    results.push_back(measure("extend_timestamp", ops, repetitions, counter, [&]() {
+        uint64_t sum = 0;
+        uint64_t minimum = 1ULL << 32;
+        for (size_t i = 0; i < ops; ++i) {
+            sum += extend_timestamp(toa30[i], minimum, 30);
+        }
+        return sum;
+    }));
+
+    results.push_back(measure("TimestampExtender::extendPixel", ops, repetitions, counter, [&]() {
+        TimestampExtender extender;
+        uint64_t sum = 0;
+        for (size_t i = 0; i < ops; ++i) {
+            sum += extender.extendPixel(static_cast<uint8_t>(i & 3), hits[i].toa_ns);
+        }
+        return sum;
+    }));
+
+    results.push_back(measure("PacketReorderBuffer::processPacket", ops, repetitions, counter, [&]() {
+        PacketReorderBuffer reorder(1000, true);
+        reorder.resetForNewChunk(1);
+        uint64_t sum = 0;
+        auto callback = [&sum](uint64_t word, uint64_t, uint64_t) { sum += word; };
+        for (size_t i = 0; i < ops; ++i) {
+            reorder.processPacket(packet_ids[i], packet_ids[i], 1, callback);
+        }
+        reorder.flush(callback);
+        return sum;
+    }));
+
+    results.push_back(measure("HitProcessor::addHit", ops, repetitions, counter, [&]() {
+        HitProcessor processor(4);
+        processor.setRecentHitCapacity(10);
+        for (size_t i = 0; i < ops; ++i) {
+            processor.addHit(hits[i]);
+        }
+        return processor.getStatistics().total_hits;
+    }));
+
+    // Chunk sorts: ns/op is per hit. Each run sorts fresh copies of the same
+    // blocks; the copy is timed too and costs the same for every method.
+    const std::pair<size_t, uint64_t> sort_cases[] = {
+        {256, 1ULL << 20}, {1024, 1ULL << 20}, {8192, 1ULL << 30}, {65536, 1ULL << 30}};
+    for (const auto& sort_case : sort_cases) {
+        size_t block_hits = sort_case.first;
+        std::vector<HitBlock> input = makeSortBlocks(ops, block_hits, sort_case.second, rng);
+        std::vector<HitBlock> work = input;
+        size_t sort_ops = input.size() * block_hits;
+        std::string suffix = " n=" + std::to_string(block_hits);
+        HitSortScratch scratch;
+        auto sort_with = [&](const std::function<void(HitBlock&)>& sort) {
+            uint64_t sum = 0;
+            for (size_t b = 0; b < input.size(); ++b) {
+                work[b] = input[b];
+                sort(work[b]);
+                sum += work[b].toa[block_hits / 2];
+            }
+            return sum;
+        };
+        results.push_back(measure("radix_sort_hits_by_toa" + suffix, sort_ops, repetitions, counter, [&]() {
+            return sort_with([&scratch](HitBlock& block) { radix_sort_hits_by_toa(block, scratch); });
+        }));
+        results.push_back(measure("sort_hits_by_toa (stable)" + suffix, sort_ops, repetitions, counter, [&]() {
+            return sort_with([](HitBlock& block) { sort_hits_by_toa(block); });
+        }));
+        results.push_back(measure("std::sort" + suffix, sort_ops, repetitions, counter, [&]() {
+            return sort_with(std_sort_hits_by_toa);
+        }));
+    }
+
+    std::cout << "Decoder kernel microbenchmarks (" << ops << " ops, best of " << repetitions << ")" << std::endl;
+    if (!counter.available()) {
+        std::cout << "CPU cycle counter unavailable (perf_event_open failed); reporting ns/op only" << std::endl;
+    }
+    std::cout << std::left << std::setw(40) << "Kernel" << std::right << std::setw(12) << "ns/op";
+    if (counter.available()) {
+        std::cout << std::setw(14) << "cycles/op";
+    }
+    std::cout << std::endl;
+    for (const KernelResult& r : results) {
+        std::cout << std::left << std::setw(40) << r.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(12) << r.ns_per_op;
+        if (counter.available()) {
+            std::cout << std::setw(14) << r.cycles_per_op;
+        }
+        std::cout << std::endl;
+    }
+
+    if (!json_file.empty()) {
+        std::ostringstream json;
+        json << std::setprecision(6);
+        json << "{\n  \"benchmark\": \"decoder_kernels\",\n  \"ops\": " << ops << ",\n  \"repetitions\": " << repetitions
+             << ",\n  \"cycle_counter\": " << (counter.available() ? "true" : "false") << ",\n  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const KernelResult& r = results[i];
+            json << "    {\"kernel\": \"" << r.name << "\", \"ns_per_op\": " << r.ns_per_op;
+            if (counter.available()) {
+                json << ", \"cycles_per_op\": " << r.cycles_per_op;
+            }
+            json << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        json << "  ]\n}\n";
+        std::ofstream out(json_file);
+        out << json.str();
+        if (!out) {
+            std::cerr << "Error: cannot write " << json_file << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,311 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+// End-to-end pipeline benchmark: feeds a generated stream through the same
+// code path as the parser's TCP mode (RawDataQueue -> processing thread ->
+// process_raw_data framing -> DecodeDispatcher workers -> HitProcessor
+// statistics, optional reorder buffer and time-ordered merge output) and
+// sweeps decoder workers, queue sizes and batch sizes. Results are written
+// as JSON so runs can be compared across commits and machines.
+//
+// Per-buffer latency is measured from enqueue to the end of its framing and
+// dispatch in the processing thread (queueing plus process_raw_data).
+
+#include "decode_pipeline.h"
+#include "tpx3_generator.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchCase {
+    size_t workers;
+    size_t queue_size;
+    size_t batch_size;
+    bool reorder;
+    bool time_order;
+};
+
+struct BenchResult {
+    BenchCase config;
+    double wall_s = 0.0;
+    double words_per_s = 0.0;
+    double hits_per_s = 0.0;
+    double latency_p50_us = 0.0;
+    double latency_p99_us = 0.0;
+    double cpu_cores = 0.0;          // CPU seconds per wall second
+    uint64_t hits = 0;
+    uint64_t dropped_buffers = 0;
+};
+
+double cpu_seconds() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1.0e-6;
+}
+
+double percentile(std::vector<double>& values, double fraction) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(fraction * static_cast<double>(values.size())));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+    return values[index];
+}
+
+BenchResult run_case(const BenchCase& bench, const std::vector<uint64_t>& stream, size_t buffer_bytes,
+                     size_t chip_count) {
+    BenchResult result;
+    result.config = bench;
+
+    HitProcessor processor(chip_count);
+    processor.setRecentHitCapacity(0);
+    StreamState state;
+    state.batch_size = bench.batch_size;
+
+    std::unique_ptr<TimeOrderedMerger> merger;
+    BlockStageConfig stages;
+    if (bench.time_order) {
+        TimeOrderedMerger::Config merge_config;
+        merge_config.expected_chips = chip_count;
+        merge_config.max_delay_ticks = 1ULL << 50;  // Replay runs far ahead of real time
+        merger = std::make_unique<TimeOrderedMerger>(merge_config, [](const HitBlock&) {});
+        stages.merger = merger.get();
+    }
+    std::unique_ptr<ChunkHitCollector> inline_collector;
+    std::unique_ptr<DecodeDispatcher> dispatcher;
+    if (bench.workers > 1) {
+        dispatcher = std::make_unique<DecodeDispatcher>(bench.workers, processor, 0, state.decode, stages);
+    } else if (stages.enabled()) {
+        inline_collector = std::make_unique<ChunkHitCollector>(stages);
+        state.decode.collector = inline_collector.get();
+    }
+    std::unique_ptr<PacketReorderBuffer> reorder;
+    if (bench.reorder) {
+        reorder = std::make_unique<PacketReorderBuffer>(1000, true);
+    }
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(stream.data());
+    const size_t total_bytes = stream.size() * sizeof(uint64_t);
+    const size_t buffer_count = (total_bytes + buffer_bytes - 1) / buffer_bytes;
+    std::vector<Clock::time_point> enqueued(buffer_count);
+    std::vector<double> latencies_us;
+    latencies_us.reserve(buffer_count);
+
+    RawDataQueue queue(bench.queue_size);
+    double cpu_start = cpu_seconds();
+    Clock::time_point start = Clock::now();
+
+    std::thread processing([&]() {
+        RawDataQueue::Buffer buffer;
+        size_t index = 0;
+        while (true) {
+            if (queue.pop(buffer, std::chrono::milliseconds(100))) {
+                process_raw_data(buffer.bytes(), buffer.size, processor, state, dispatcher.get(),
+                                 reorder.get(), true);
+                latencies_us.push_back(
+                    std::chrono::duration<double, std::micro>(Clock::now() - enqueued[index++]).count());
+            } else if (queue.isStopped() && queue.size() == 0) {
+                break;
+            }
+        }
+    });
+
+    // Producer: like the network thread, but waits instead of dropping so
+    // every configuration processes the same data
+    for (size_t i = 0; i < buffer_count; ++i) {
+        while (queue.size() >= bench.queue_size) {
+            std::this_thread::yield();
+        }
+        size_t offset = i * buffer_bytes;
+        enqueued[i] = Clock::now();
+        queue.push(bytes + offset, std::min(buffer_bytes, total_bytes - offset));
+    }
+    queue.stop();
+    processing.join();
+    if (dispatcher) {
+        dispatcher->waitUntilIdle();
+        dispatcher->finishChunks();
+    } else if (inline_collector) {
+        inline_collector->finishAll();
+    }
+    if (merger) {
+        merger->flush();
+    }
+
+    result.wall_s = std::chrono::duration<double>(Clock::now() - start).count();
+    result.cpu_cores = (cpu_seconds() - cpu_start) / result.wall_s;
+    result.hits = processor.getStatistics().total_hits;
+    result.words_per_s = static_cast<double>(stream.size()) / result.wall_s;
+    result.hits_per_s = static_cast<double>(result.hits) / result.wall_s;
+    result.latency_p50_us = percentile(latencies_us, 0.50);
+    result.latency_p99_us = percentile(latencies_us, 0.99);
+    result.dropped_buffers = queue.getDroppedBuffers();
+    return result;
+}
+
+std::vector<size_t> parse_list(const std::string& text) {
+    std::vector<size_t> values;
+    std::stringstream fields(text);
+    std::string field;
+    while (std::getline(fields, field, ',')) {
+        values.push_back(std::stoul(field));
+    }
+    return values;
+}
+
+void printUsage(const char* prog_name) {
+    std::cout << "Usage: " << prog_name << " [OPTIONS]\n"
+              << "Options:\n"
+              << "  --output FILE            JSON results (default: bench_results.json, - = stdout)\n"
+              << "  --workers LIST           Decoder worker counts (default: 1,2,4)\n"
+              << "  --queue-sizes LIST       Raw data queue sizes in buffers (default: 16,2000)\n"
+              << "  --batch-sizes LIST       Words per dispatcher submission (default: 32,128,512)\n"
+              << "  --buffer-kb N            Raw buffer size, like one TCP read (default: 1024)\n"
+              << "  --chips N                Chips in the generated stream (default: 4)\n"
+              << "  --hot-chip-share F       Fraction of the hits on chip 0 (default: 0 = even split)\n"
+              << "  --hits N                 Hits in the generated stream (default: 4000000)\n"
+              << "  --seed N                 Generator seed (default: 1)\n"
+              << "  --quick                  Small sweep and stream, for a fast check\n"
+              << "  --help                   Show this help message\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string output_file = "bench_results.json";
+    std::vector<size_t> workers = {1, 2, 4};
+    std::vector<size_t> queue_sizes = {16, 2000};
+    std::vector<size_t> batch_sizes = {32, 128, 512};
+    size_t buffer_bytes = 1024 * 1024;
+    Tpx3Generator::Config generator_config;
+    generator_config.chip_count = 4;
+    double total_hits = 4.0e6;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--output" && i + 1 < argc) {
+            output_file = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            workers = parse_list(argv[++i]);
+        } else if (arg == "--queue-sizes" && i + 1 < argc) {
+            queue_sizes = parse_list(argv[++i]);
+        } else if (arg == "--batch-sizes" && i + 1 < argc) {
+            batch_sizes = parse_list(argv[++i]);
+        } else if (arg == "--buffer-kb" && i + 1 < argc) {
+            buffer_bytes = std::max<size_t>(1, std::stoul(argv[++i])) * 1024;
+        } else if (arg == "--chips" && i + 1 < argc) {
+            generator_config.chip_count = std::stoul(argv[++i]);
+        } else if (arg == "--hot-chip-share" && i + 1 < argc) {
+            generator_config.hot_chip_share = std::stod(argv[++i]);
+        } else if (arg == "--hits" && i + 1 < argc) {
+            total_hits = std::stod(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            generator_config.seed = std::stoull(argv[++i]);
+        } else if (arg == "--quick") {
+            workers = {1, 2};
+            queue_sizes = {2000};
+            batch_sizes = {128};
+            total_hits = 5.0e5;
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    // One stream for every case: 10 MHz over the chips, 1 ms chunks
+    generator_config.hit_rate_hz = 1.0e7;
+    generator_config.duration_s = total_hits / generator_config.hit_rate_hz;
+    Tpx3Generator generator(generator_config);
+    std::vector<uint64_t> stream;
+    while (generator.nextChunk(stream)) {
+    }
+    const Tpx3Generator::Statistics& generated = generator.getStatistics();
+    std::cerr << "Generated " << generated.words << " words, " << generated.hits << " hits" << std::endl;
+
+    std::vector<BenchCase> cases;
+    for (size_t w : workers) {
+        for (size_t q : queue_sizes) {
+            for (size_t b : batch_sizes) {
+                cases.push_back({w, q, b, false, false});
+            }
+        }
+    }
+    // Optional stages at the default tuning
+    cases.push_back({workers.back(), 2000, StreamState::DEFAULT_BATCH_SIZE, true, false});
+    cases.push_back({workers.back(), 2000, StreamState::DEFAULT_BATCH_SIZE, false, true});
+
+    std::vector<BenchResult> results;
+    for (const BenchCase& bench : cases) {
+        BenchResult result = run_case(bench, stream, buffer_bytes, generator.config().chip_count);
+        std::cerr << "workers=" << bench.workers << " queue=" << bench.queue_size << " batch=" << bench.batch_size
+                  << (bench.reorder ? " reorder" : "") << (bench.time_order ? " time-order" : "") << ": "
+                  << std::fixed << std::setprecision(2) << result.words_per_s / 1.0e6 << " Mwords/s, "
+                  << result.hits_per_s / 1.0e6 << " Mhits/s, p99 " << std::setprecision(0)
+                  << result.latency_p99_us << " us" << std::endl;
+        if (result.hits != generated.hits) {
+            std::cerr << "  Error: decoded " << result.hits << " of " << generated.hits << " hits" << std::endl;
+        }
+        results.push_back(result);
+    }
+
+    std::ostringstream json;
+    json << std::setprecision(6);
+    json << "{\n";
+    json << "  \"benchmark\": \"pipeline\",\n";
+    json << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+    json << "  \"stream\": {\"seed\": " << generator_config.seed << ", \"chips\": " << generator.config().chip_count
+         << ", \"hot_chip_share\": " << generator.config().hot_chip_share
+         << ", \"words\": " << generated.words << ", \"hits\": " << generated.hits
+         << ", \"buffer_bytes\": " << buffer_bytes << "},\n";
+    json << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        json << "    {\"workers\": " << r.config.workers << ", \"queue_size\": " << r.config.queue_size
+             << ", \"batch_size\": " << r.config.batch_size << ", \"reorder\": " << (r.config.reorder ? "true" : "false")
+             << ", \"time_order\": " << (r.config.time_order ? "true" : "false") << ", \"wall_s\": " << r.wall_s
+             << ", \"words_per_s\": " << r.words_per_s << ", \"hits_per_s\": " << r.hits_per_s
+             << ", \"latency_p50_us\": " << r.latency_p50_us << ", \"latency_p99_us\": " << r.latency_p99_us
+             << ", \"cpu_cores\": " << r.cpu_cores << ", \"hits_decoded\": " << r.hits
+             << ", \"hits_ok\": " << (r.hits == generated.hits ? "true" : "false")
+             << ", \"dropped_buffers\": " << r.dropped_buffers << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    json << "  ]\n}\n";
+
+    if (output_file == "-") {
+        std::cout << json.str();
+    } else {
+        std::ofstream out(output_file);
+        out << json.str();
+        if (!out) {
+            std::cerr << "Error: cannot write " << output_file << std::endl;
+            return 1;
+        }
+        std::cerr << "Results written to " << output_file << std::endl;
+    }
+    bool all_ok = std::all_of(results.begin(), results.end(),
+                              [&](const BenchResult& r) { return r.hits == generated.hits; });
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+// Reads the statistics the parser publishes with --stats-shm NAME, as an
+// example of a local consumer of the seqlock-protected segment.
+
+#include "stats_publisher.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+void printUsage(const char* prog_name) {
+    std::cout << "Usage: " << prog_name << " [OPTIONS]\n"
+              << "Options:\n"
+              << "  --name NAME      Shared-memory segment name (default: /tpx3_stats)\n"
+              << "  --watch MS       Print a snapshot every MS milliseconds until interrupted\n"
+              << "  --json           Print the JSON snapshot instead of the summary\n"
+              << "  --help           Show this help message\n";
+}
+
+void printRecord(const StatsShmRecord& record) {
+    std::cout << "seq=" << record.sequence << " elapsed=" << std::fixed << std::setprecision(1)
+              << record.elapsed_s << "s hits=" << record.total_hits << " chunks=" << record.total_chunks
+              << " tdc1=" << record.total_tdc1_events << " hit_rate=" << std::setprecision(0)
+              << record.hit_rate_hz << " Hz decode_errors=" << record.total_decode_errors << std::endl;
+    for (uint32_t chip = 0; chip < record.chip_count; ++chip) {
+        std::cout << "  Chip " << chip << ": " << std::setprecision(2) << record.chip_hit_rates_hz[chip]
+                  << " Hz, TDC1 " << record.chip_tdc1_counts[chip] << std::endl;
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string name = "/tpx3_stats";
+    int watch_ms = 0;
+    bool json_output = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--name" && i + 1 < argc) {
+            name = argv[++i];
+        } else if (arg == "--watch" && i + 1 < argc) {
+            watch_ms = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--json") {
+            json_output = true;
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "shm_open(" << name << "): " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    void* memory = mmap(nullptr, sizeof(StatsShmSegment), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        std::cerr << "mmap: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    const StatsShmSegment& segment = *static_cast<const StatsShmSegment*>(memory);
+
+    uint64_t last_sequence = 0;
+    do {
+        StatsShmRecord record;
+        std::string json;
+        if (stats_shm_read(segment, record, json)) {
+            if (record.sequence != last_sequence) {
+                if (json_output) {
+                    std::cout << json << std::endl;
+                } else {
+                    printRecord(record);
+                }
+                last_sequence = record.sequence;
+            }
+        } else if (watch_ms == 0) {
+            std::cerr << "No statistics published in " << name << std::endl;
+            munmap(memory, sizeof(StatsShmSegment));
+            return 1;
+        }
+        if (watch_ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(watch_ms));
+        }
+    } while (watch_ms > 0);
+
+    munmap(memory, sizeof(StatsShmSegment));
+    return 0;
+}
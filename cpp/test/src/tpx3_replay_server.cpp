@@ -0,0 +1,328 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+// TCP replay server: serves a recorded .tpx3 file to one client (tpx3_parser
+// or tcp_raw_test) in place of SERVAL, paced to a target MB/s or hits/s,
+// optionally in bursts and looped, and reports the rate actually achieved.
+//
+// Data leaves through sendfile(2), so the file is never copied to user space.
+// Unpaced (no rate), the send blocks whenever the client's receive buffer is
+// full, so the achieved rate is the client's sustainable ingest rate.
+
+#include "tpx3_packets.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct ReplayStats {
+    uint64_t bytes = 0;
+    uint64_t loops = 0;
+    double blocked_s = 0.0;  // Time inside sendfile (client back-pressure when unpaced)
+};
+
+void printUsage(const char* prog_name) {
+    std::cout << "Usage: " << prog_name << " --input FILE [OPTIONS]\n"
+              << "Options:\n"
+              << "  --input FILE             Recorded .tpx3 file to serve\n"
+              << "  --host HOST              Listen address (default: 127.0.0.1)\n"
+              << "  --port PORT              Listen port (default: 8085)\n"
+              << "  --rate-mbps MB/S         Target rate in MB/s (default: 0 = as fast as the client reads)\n"
+              << "  --rate-hits HITS/S       Target rate in pixel hits/s (converted using the file's hit density)\n"
+              << "  --burst ON_MS,OFF_MS     Send for ON_MS at the target rate, then pause OFF_MS\n"
+              << "  --loop N                 Serve the file N times (default: 1, 0 = until the client disconnects)\n"
+              << "  --stats-interval SECONDS Statistics print interval (default: 1)\n"
+              << "  --help                   Show this help message\n";
+}
+
+// Count pixel words by walking the chunk structure (a bare top-nibble test
+// would also match chunk headers, whose top bits are the chunk size)
+uint64_t count_pixel_words(int fd, uint64_t file_size) {
+    std::vector<uint64_t> words(1 << 17);
+    uint64_t offset = 0;
+    uint64_t pixels = 0;
+    uint64_t remaining = 0;
+    while (offset < file_size) {
+        ssize_t got = pread(fd, words.data(), words.size() * sizeof(uint64_t), static_cast<off_t>(offset));
+        if (got <= 0) {
+            break;
+        }
+        size_t count = static_cast<size_t>(got) / sizeof(uint64_t);
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t word = words[i];
+            if ((word & 0xFFFFFFFFULL) == TPX3_MAGIC) {
+                remaining = ((word >> 48) & 0xFFFF) / 8;
+            } else if (remaining > 0) {
+                remaining--;
+                uint8_t type = static_cast<uint8_t>(word >> 60);
+                pixels += (type == PIXEL_STANDARD || type == PIXEL_COUNT_FB);
+            }
+        }
+        offset += count * sizeof(uint64_t);
+        if (count == 0) {
+            break;
+        }
+    }
+    return pixels;
+}
+
+int acceptClient(const std::string& host, uint16_t port) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Error: socket: " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "Error: invalid listen address " << host << std::endl;
+        close(listener);
+        return -1;
+    }
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listener, 1) < 0) {
+        std::cerr << "Error: cannot listen on " << host << ":" << port << ": " << std::strerror(errno)
+                  << std::endl;
+        close(listener);
+        return -1;
+    }
+    std::cout << "Listening on " << host << ":" << port << ", waiting for a client..." << std::endl;
+    int client = accept(listener, nullptr, nullptr);
+    close(listener);
+    if (client < 0) {
+        std::cerr << "Error: accept: " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    int nodelay = 1;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    return client;
+}
+
+void printRate(const char* label, uint64_t bytes, double seconds, double hits_per_byte) {
+    if (seconds <= 0.0) {
+        return;
+    }
+    double mbps = static_cast<double>(bytes) / seconds / 1.0e6;
+    std::cout << label << std::fixed << std::setprecision(1) << mbps << " MB/s";
+    if (hits_per_byte > 0.0) {
+        std::cout << ", " << std::setprecision(2) << static_cast<double>(bytes) * hits_per_byte / seconds / 1.0e6
+                  << " Mhits/s";
+    }
+    std::cout << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string input_file;
+    std::string host = "127.0.0.1";
+    uint16_t port = 8085;
+    double rate_mbps = 0.0;
+    double rate_hits = 0.0;
+    double burst_on_ms = 0.0;
+    double burst_off_ms = 0.0;
+    uint64_t loops = 1;
+    double stats_interval = 1.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--input" && i + 1 < argc) {
+            input_file = argv[++i];
+        } else if (arg == "--host" && i + 1 < argc) {
+            host = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = static_cast<uint16_t>(std::stoul(argv[++i]));
+        } else if (arg == "--rate-mbps" && i + 1 < argc) {
+            rate_mbps = std::stod(argv[++i]);
+        } else if (arg == "--rate-hits" && i + 1 < argc) {
+            rate_hits = std::stod(argv[++i]);
+        } else if (arg == "--burst" && i + 1 < argc) {
+            char extra;
+            if (std::sscanf(argv[++i], "%lf,%lf%c", &burst_on_ms, &burst_off_ms, &extra) != 2 ||
+                burst_on_ms <= 0.0 || burst_off_ms < 0.0) {
+                std::cerr << "Error: --burst expects ON_MS,OFF_MS" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--loop" && i + 1 < argc) {
+            loops = std::stoull(argv[++i]);
+        } else if (arg == "--stats-interval" && i + 1 < argc) {
+            stats_interval = std::stod(argv[++i]);
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (input_file.empty()) {
+        std::cerr << "Error: --input FILE is required" << std::endl;
+        return 1;
+    }
+    if (rate_mbps > 0.0 && rate_hits > 0.0) {
+        std::cerr << "Error: specify at most one of --rate-mbps and --rate-hits" << std::endl;
+        return 1;
+    }
+
+    int fd = open(input_file.c_str(), O_RDONLY);
+    struct stat st{};
+    if (fd < 0 || fstat(fd, &st) < 0) {
+        std::cerr << "Error: cannot open " << input_file << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    // Whole words only; a trailing partial word would misalign the next loop
+    const uint64_t file_size = static_cast<uint64_t>(st.st_size) & ~7ULL;
+    if (file_size == 0) {
+        std::cerr << "Error: " << input_file << " is empty" << std::endl;
+        return 1;
+    }
+    uint64_t pixel_words = count_pixel_words(fd, file_size);
+    double hits_per_byte = static_cast<double>(pixel_words) / static_cast<double>(file_size);
+    double rate_bytes = rate_mbps * 1.0e6;
+    if (rate_hits > 0.0) {
+        if (pixel_words == 0) {
+            std::cerr << "Error: --rate-hits needs pixel data, " << input_file << " has none" << std::endl;
+            return 1;
+        }
+        rate_bytes = rate_hits / hits_per_byte;
+    }
+
+    std::cout << "TPX3 Replay Server" << std::endl;
+    std::cout << "Input: " << input_file << " (" << file_size << " bytes, " << pixel_words << " hits)" << std::endl;
+    if (rate_bytes > 0.0) {
+        std::cout << "Target rate: " << std::fixed << std::setprecision(1) << rate_bytes / 1.0e6 << " MB/s";
+        if (hits_per_byte > 0.0) {
+            std::cout << " (" << std::setprecision(2) << rate_bytes * hits_per_byte / 1.0e6 << " Mhits/s)";
+        }
+        std::cout << std::endl;
+    } else {
+        std::cout << "Target rate: unpaced (client-limited)" << std::endl;
+    }
+    if (burst_on_ms > 0.0) {
+        std::cout << "Bursts: " << burst_on_ms << " ms on, " << burst_off_ms << " ms off" << std::endl;
+    }
+    std::cout << "Loops: " << (loops == 0 ? std::string("until disconnect") : std::to_string(loops)) << std::endl;
+
+    // sendfile() has no MSG_NOSIGNAL: a client that disconnects must surface as
+    // EPIPE, not kill the server before it prints its statistics
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int client = acceptClient(host, port);
+    if (client < 0) {
+        return 1;
+    }
+    std::cout << "Client connected, replaying..." << std::endl;
+
+    // Paced sends go out in ~1ms slices so the rate is smooth at the scale
+    // of the client's socket buffer; unpaced ones in large slices
+    const uint64_t slice = rate_bytes > 0.0
+        ? std::max<uint64_t>(8, static_cast<uint64_t>(rate_bytes * 1.0e-3) & ~7ULL)
+        : (4ULL << 20);
+    const auto burst_on = std::chrono::duration<double, std::milli>(burst_on_ms);
+    const auto burst_off = std::chrono::duration<double, std::milli>(burst_off_ms);
+
+    ReplayStats stats;
+    const Clock::time_point start = Clock::now();
+    Clock::time_point last_report = start;
+    uint64_t last_report_bytes = 0;
+    double active_s = 0.0;              // Time in on-phases; pacing runs on this clock
+    Clock::time_point phase_start = start;
+    bool ok = true;
+    bool disconnected = false;  // EPIPE / ECONNRESET: the normal end of --loop 0
+
+    while (ok && (loops == 0 || stats.loops < loops)) {
+        off_t offset = 0;
+        while (ok && static_cast<uint64_t>(offset) < file_size) {
+            Clock::time_point now = Clock::now();
+            if (burst_on_ms > 0.0 && now - phase_start >= burst_on) {
+                active_s += std::chrono::duration<double>(now - phase_start).count();
+                std::this_thread::sleep_for(burst_off);
+                phase_start = Clock::now();
+                now = phase_start;
+            }
+            if (rate_bytes > 0.0) {
+                // Token bucket on active time: never ahead of rate * elapsed
+                double active_now = active_s + std::chrono::duration<double>(now - phase_start).count();
+                double due_s = static_cast<double>(stats.bytes) / rate_bytes;
+                if (due_s > active_now) {
+                    std::this_thread::sleep_for(std::chrono::duration<double>(due_s - active_now));
+                }
+            }
+
+            size_t count = static_cast<size_t>(std::min<uint64_t>(slice, file_size - offset));
+            Clock::time_point send_start = Clock::now();
+            ssize_t sent = sendfile(client, fd, &offset, count);
+            stats.blocked_s += std::chrono::duration<double>(Clock::now() - send_start).count();
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EPIPE || errno == ECONNRESET) {
+                    disconnected = true;
+                } else {
+                    std::cerr << "Error: sendfile: " << std::strerror(errno) << std::endl;
+                }
+                ok = false;
+                break;
+            }
+            stats.bytes += static_cast<uint64_t>(sent);
+
+            now = Clock::now();
+            double since_report = std::chrono::duration<double>(now - last_report).count();
+            if (stats_interval > 0.0 && since_report >= stats_interval) {
+                printRate("Rate: ", stats.bytes - last_report_bytes, since_report, hits_per_byte);
+                last_report = now;
+                last_report_bytes = stats.bytes;
+            }
+        }
+        if (ok) {
+            stats.loops++;
+        }
+    }
+    if (disconnected) {
+        std::cout << "Client disconnected" << std::endl;
+    }
+    shutdown(client, SHUT_WR);
+    close(client);
+    close(fd);
+
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << "\n=== Replay Statistics ===" << std::endl;
+    std::cout << "Bytes sent: " << stats.bytes << " (" << stats.loops << " complete loops)" << std::endl;
+    std::cout << "Elapsed: " << std::fixed << std::setprecision(3) << elapsed << " s" << std::endl;
+    printRate("Achieved rate: ", stats.bytes, elapsed, hits_per_byte);
+    if (elapsed > 0.0) {
+        std::cout << "Time blocked in send: " << std::setprecision(1) << 100.0 * stats.blocked_s / elapsed
+                  << "% (high when the client cannot keep up)" << std::endl;
+    }
+    return ok || (disconnected && loops == 0) ? 0 : 1;
+}
@@ -0,0 +1,259 @@
+/*
+ * Author: Kazimierz Gofron
+ *         Oak Ridge National Laboratory
+ *
+ * Created:  November 2, 2025
+ * Modified: November 8, 2025
+ */
+
+// Synthetic TPX3 stream generator: writes a deterministic chunked raw stream
+// to a file, or serves it to one client on a local TCP socket in place of
+// SERVAL, so the parser can be exercised and benchmarked offline.
+
+#include "tpx3_generator.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void printUsage(const char* prog_name) {
+    std::cout << "Usage: " << prog_name << " [OPTIONS]\n"
+              << "Output (one of):\n"
+              << "  --output FILE              Write the stream to FILE\n"
+              << "  --listen                   Serve the stream to one TCP client\n"
+              << "  --host HOST                Listen address (default: 127.0.0.1)\n"
+              << "  --port PORT                Listen port (default: 8085)\n"
+              << "  --realtime                 Pace TCP output to data time\n"
+              << "\n"
+              << "Stream:\n"
+              << "  --seed N                   Random seed (default: 1)\n"
+              << "  --chips N                  Number of chips (default: 4)\n"
+              << "  --duration SECONDS         Data time to generate (default: 1)\n"
+              << "  --hit-rate HZ              Pixel hits per second, all chips (default: 1e6)\n"
+              << "  --chunk-period-us US       Data time per chunk (default: 1000)\n"
+              << "  --cluster-size N           Mean pixels per event (default: 4)\n"
+              << "  --beam-sigma PX            Gaussian beam spot width (default: 0 = uniform)\n"
+              << "  --hot-chip-share F         Fraction of the hits on chip 0 (default: 0 = even split)\n"
+              << "  --tdc-hz HZ                TDC1 pulse frequency (default: 60, 0 = none)\n"
+              << "  --tdc-chip N               Chip receiving TDC1 (default: 0)\n"
+              << "  --global-time-interval S   Global time period (default: 0.1, 0 = none)\n"
+              << "  --packet-id-interval N     Words per SPIDR packet ID (default: 64, 0 = none)\n"
+              << "  --count-fb                 Emit count_fb (0xa) pixel words\n"
+              << "  --no-extra-timestamps      Do not close chunks with extra timestamps\n"
+              << "\n"
+              << "Faults (probabilities):\n"
+              << "  --fault-packet-id-swap P   Swap consecutive SPIDR packet IDs\n"
+              << "  --fault-truncated-chunk P  Cut chunks short of their header size\n"
+              << "  --fault-bad-tdc P          TDC fractional part outside 1-12\n"
+              << "  --help                     Show this help message\n";
+}
+
+void printStatistics(const Tpx3Generator::Statistics& stats, double elapsed_s) {
+    double mbytes = static_cast<double>(stats.words) * 8.0 / 1.0e6;
+    std::cout << "\n=== Generator Statistics ===" << std::endl;
+    std::cout << "Chunks: " << stats.chunks << std::endl;
+    std::cout << "Words: " << stats.words << " (" << std::fixed << std::setprecision(2) << mbytes
+              << " MB)" << std::endl;
+    std::cout << "Events: " << stats.events << std::endl;
+    std::cout << "Hits: " << stats.hits << std::endl;
+    std::cout << "TDC1 pulses: " << stats.tdc_events << std::endl;
+    std::cout << "Global time pairs: " << stats.global_time_pairs << std::endl;
+    std::cout << "SPIDR packet IDs: " << stats.packet_ids << std::endl;
+    std::cout << "Faults: packet ID swaps " << stats.faults_packet_id_swap << ", truncated chunks "
+              << stats.faults_truncated_chunk << ", bad TDC fractions " << stats.faults_bad_tdc_fraction
+              << std::endl;
+    if (elapsed_s > 0.0) {
+        std::cout << "Elapsed: " << std::setprecision(3) << elapsed_s << " s (" << std::setprecision(1)
+                  << mbytes / elapsed_s << " MB/s)" << std::endl;
+    }
+}
+
+bool sendAll(int fd, const uint64_t* words, size_t count) {
+    const char* data = reinterpret_cast<const char*>(words);
+    size_t remaining = count * sizeof(uint64_t);
+    while (remaining > 0) {
+        ssize_t sent = send(fd, data, remaining, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += sent;
+        remaining -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+int acceptClient(const std::string& host, uint16_t port) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "Error: socket: " << std::strerror(errno) << std::endl;
+        return -1;
+    }
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "Error: invalid listen address " << host << std::endl;
+        close(listener);
+        return -1;
+    }
+    if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listener, 1) < 0) {
+        std::cerr << "Error: cannot listen on " << host << ":" << port << ": " << std::strerror(errno)
+                  << std::endl;
+        close(listener);
+        return -1;
+    }
+    std::cout << "Listening on " << host << ":" << port << ", waiting for a client..." << std::endl;
+    int client = accept(listener, nullptr, nullptr);
+    close(listener);
+    if (client < 0) {
+        std::cerr << "Error: accept: " << std::strerror(errno) << std::endl;
+    }
+    return client;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    Tpx3Generator::Config config;
+    std::string output_file;
+    bool listen_tcp = false;
+    std::string host = "127.0.0.1";
+    uint16_t port = 8085;
+    bool realtime = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--output" && i + 1 < argc) {
+            output_file = argv[++i];
+        } else if (arg == "--listen") {
+            listen_tcp = true;
+        } else if (arg == "--host" && i + 1 < argc) {
+            host = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = static_cast<uint16_t>(std::stoul(argv[++i]));
+        } else if (arg == "--realtime") {
+            realtime = true;
+        } else if (arg == "--seed" && i + 1 < argc) {
+            config.seed = std::stoull(argv[++i]);
+        } else if (arg == "--chips" && i + 1 < argc) {
+            config.chip_count = std::stoul(argv[++i]);
+        } else if (arg == "--duration" && i + 1 < argc) {
+            config.duration_s = std::stod(argv[++i]);
+        } else if (arg == "--hit-rate" && i + 1 < argc) {
+            config.hit_rate_hz = std::stod(argv[++i]);
+        } else if (arg == "--chunk-period-us" && i + 1 < argc) {
+            config.chunk_period_s = std::stod(argv[++i]) * 1.0e-6;
+        } else if (arg == "--cluster-size" && i + 1 < argc) {
+            config.cluster_size_mean = std::stod(argv[++i]);
+        } else if (arg == "--beam-sigma" && i + 1 < argc) {
+            config.beam_sigma_px = std::stod(argv[++i]);
+        } else if (arg == "--hot-chip-share" && i + 1 < argc) {
+            config.hot_chip_share = std::stod(argv[++i]);
+        } else if (arg == "--tdc-hz" && i + 1 < argc) {
+            config.tdc_frequency_hz = std::stod(argv[++i]);
+        } else if (arg == "--tdc-chip" && i + 1 < argc) {
+            config.tdc_chip = static_cast<uint8_t>(std::stoul(argv[++i]));
+        } else if (arg == "--global-time-interval" && i + 1 < argc) {
+            config.global_time_interval_s = std::stod(argv[++i]);
+        } else if (arg == "--packet-id-interval" && i + 1 < argc) {
+            config.packet_id_interval = std::stoul(argv[++i]);
+        } else if (arg == "--count-fb") {
+            config.count_fb = true;
+        } else if (arg == "--no-extra-timestamps") {
+            config.extra_timestamps = false;
+        } else if (arg == "--fault-packet-id-swap" && i + 1 < argc) {
+            config.fault_packet_id_swap = std::stod(argv[++i]);
+        } else if (arg == "--fault-truncated-chunk" && i + 1 < argc) {
+            config.fault_truncated_chunk = std::stod(argv[++i]);
+        } else if (arg == "--fault-bad-tdc" && i + 1 < argc) {
+            config.fault_bad_tdc_fraction = std::stod(argv[++i]);
+        } else if (arg == "--help") {
+            printUsage(argv[0]);
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (output_file.empty() == !listen_tcp) {
+        std::cerr << "Error: specify exactly one of --output FILE or --listen" << std::endl;
+        return 1;
+    }
+
+    Tpx3Generator generator(config);
+    std::cout << "TPX3 Stream Generator" << std::endl;
+    std::cout << "Seed: " << config.seed << ", chips: " << generator.config().chip_count
+              << ", duration: " << config.duration_s << " s, hit rate: " << config.hit_rate_hz << " Hz"
+              << std::endl;
+
+    std::ofstream out;
+    int client = -1;
+    if (listen_tcp) {
+        client = acceptClient(host, port);
+        if (client < 0) {
+            return 1;
+        }
+        std::cout << "Client connected, streaming..." << std::endl;
+    } else {
+        out.open(output_file, std::ios::binary);
+        if (!out.is_open()) {
+            std::cerr << "Error: Failed to open output file " << output_file << std::endl;
+            return 1;
+        }
+    }
+
+    // Write in batches of whole chunks
+    constexpr size_t BATCH_WORDS = 1 << 16;
+    std::vector<uint64_t> batch;
+    batch.reserve(BATCH_WORDS + Tpx3Generator::MAX_CHUNK_WORDS + 1);
+    auto start = std::chrono::steady_clock::now();
+    bool ok = true;
+    bool more = true;
+    while (ok && more) {
+        batch.clear();
+        while (batch.size() < BATCH_WORDS && (more = generator.nextChunk(batch))) {
+        }
+        if (realtime && listen_tcp) {
+            std::this_thread::sleep_until(start + std::chrono::duration<double>(generator.dataTime()));
+        }
+        if (listen_tcp) {
+            ok = sendAll(client, batch.data(), batch.size());
+            if (!ok) {
+                std::cerr << "Error: send: " << std::strerror(errno) << std::endl;
+            }
+        } else {
+            out.write(reinterpret_cast<const char*>(batch.data()),
+                      static_cast<std::streamsize>(batch.size() * sizeof(uint64_t)));
+            ok = static_cast<bool>(out);
+            if (!ok) {
+                std::cerr << "Error: write failed: " << output_file << std::endl;
+            }
+        }
+    }
+    if (client >= 0) {
+        shutdown(client, SHUT_WR);
+        close(client);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printStatistics(generator.getStatistics(), elapsed);
+    return ok ? 0 : 1;
+}